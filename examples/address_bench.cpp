@@ -0,0 +1,105 @@
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include <cppsocket/cppsocket.hpp>
+
+//Compares cpps address parsing/formatting with inet_pton/inet_ntop
+
+template<typename F>
+double ns_per_op(std::size_t ops, F&& f)
+{
+  const auto start = std::chrono::steady_clock::now();
+  f();
+  const auto end = std::chrono::steady_clock::now();
+
+  return std::chrono::duration<double, std::nano>(end - start).count() / static_cast<double>(ops);
+}
+
+std::vector<std::string> make_ipv4(std::size_t n, std::mt19937& rng)
+{
+  std::vector<std::string> res;
+  for(std::size_t i = 0; i != n; ++i)
+    res.push_back(
+      std::to_string(rng() % 256) + '.' + std::to_string(rng() % 256) + '.' +
+      std::to_string(rng() % 256) + '.' + std::to_string(rng() % 256));
+
+  return res;
+}
+
+std::vector<std::string> make_ipv6(std::size_t n, std::mt19937& rng)
+{
+  std::vector<std::string> res;
+  for(std::size_t i = 0; i != n; ++i)
+  {
+    in6_addr a{};
+    for(int b = 4; b != 16; ++b) a.s6_addr[b] = static_cast<std::uint8_t>(rng() % 4 == 0 ? 0 : rng());
+    a.s6_addr[0] = 0x20;
+    a.s6_addr[1] = 0x01;
+
+    char buf[INET6_ADDRSTRLEN];
+    inet_ntop(AF_INET6, &a, buf, sizeof(buf));
+    res.push_back(buf);
+  }
+
+  return res;
+}
+
+template<cpps::AddressFamily AF>
+void bench(const char* name, const std::vector<std::string>& texts)
+{
+  constexpr int af = static_cast<int>(AF);
+  using in_type = std::conditional_t<AF == cpps::AddressFamily::IPv4, in_addr, in6_addr>;
+
+  std::vector<in_type> sys_addrs(texts.size());
+  std::vector<cpps::Address<AF>> addrs;
+  addrs.reserve(texts.size());
+  for(const auto& t : texts) addrs.push_back(cpps::Address<AF>::make(t, 0));
+
+  std::size_t sink = 0;
+
+  const double pton = ns_per_op(texts.size(), [&]
+  {
+    for(std::size_t i = 0; i != texts.size(); ++i) inet_pton(af, texts[i].c_str(), &sys_addrs[i]);
+  });
+
+  const double make = ns_per_op(texts.size(), [&]
+  {
+    for(const auto& t : texts) sink += cpps::Address<AF>::make(t, 0).hash();
+  });
+  char buf[INET6_ADDRSTRLEN + 8];
+
+  const double ntop = ns_per_op(texts.size(), [&]
+  {
+    for(const auto& a : sys_addrs) sink += std::strlen(inet_ntop(af, &a, buf, sizeof(buf)));
+  });
+
+  const double to_chars = ns_per_op(texts.size(), [&]
+  {
+    for(const auto& a : addrs) sink += static_cast<std::size_t>(a.to_chars(buf, buf + sizeof(buf)).ptr - buf);
+  });
+
+  std::cout
+    << name << ": inet_pton " << pton << " ns, make " << make << " ns, "
+    << "inet_ntop " << ntop << " ns, to_chars (with port) " << to_chars << " ns"
+    << " [" << sink << "]" << std::endl;
+}
+
+int main() try
+{
+  std::mt19937 rng(42);
+  constexpr std::size_t n = 1000000;
+
+  bench<cpps::AddressFamily::IPv4>("IPv4", make_ipv4(n, rng));
+  bench<cpps::AddressFamily::IPv6>("IPv6", make_ipv6(n, rng));
+
+  const auto a = cpps::AddressIPv6::parse("[2001:db8::1]:6969");
+  char buf[cpps::AddressIPv6::max_string_size];
+  std::cout << std::string_view(buf, a.to_chars(buf, buf + sizeof(buf)).ptr) << std::endl;
+}
+catch(cpps::AddressError err)
+{
+  std::cout << "Error: invalid address" << std::endl;
+}
@@ -0,0 +1,358 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <new>
+#include <optional>
+#include <span>
+#include <thread>
+#include <vector>
+#include "socket.hpp"
+#include "placement.hpp"
+#include "details/nonblocking.hpp"
+#include "details/socket_access.hpp"
+#include "details/spsc_queue.hpp"
+#include "details/wakeup.hpp"
+
+namespace cpps
+{
+
+STRICT_ENUM(DispatchPolicy)
+(
+  RoundRobin,
+  LeastConnections,
+  //connection goes to worker pinned on CPU which received its handshake (see set_worker_cpus),
+  //otherwise to worker on same NUMA node, otherwise round robin
+  IncomingCpu,
+);
+
+//Accepts connections on one thread and hands them off to worker event loops.
+//Listening socket is switched to non-blocking mode, each wakeup accepts until EAGAIN,
+//connections are pushed to per worker lock-free queues, so storms of connections
+//cost one poll wakeup per batch instead of one per connection.
+//accept_pending/run_once must be called from single thread, try_pop(i) only from worker i.
+//Worker can sleep in poll on wakeup_handle(i), which becomes readable when connection is handed off to it.
+//When all queues are full, run_once waits for worker to take connection instead of accepting.
+//Connections negotiating byte order must be handshaked by worker before use (blocking connections only).
+//Listening socket must outlive dispatcher, only its handle is kept.
+template<SocketInfo SI, ConnectionSettings CS = default_connection_settings>
+  requires (SI.type != SocketType::Datagram)
+class AcceptDispatcher
+{
+public:
+  using connection_type = IncomingConnection<SI, inv_connect, CS>;
+
+private:
+  struct worker
+  {
+    details::spsc_queue<connection_type> queue;
+    alignas(details::cache_line_size) std::atomic<std::size_t> connections = 0;
+    //wakeup is signaled only when it is not already pending, so storm of connections costs one write
+    alignas(details::cache_line_size) std::atomic<bool> signaled = false;
+    details::wakeup wakeup;
+
+    explicit worker(std::size_t capacity) : queue(capacity) {}
+  };
+
+  //lets worker wake acceptor waiting for free slot
+  struct space
+  {
+    details::wakeup wakeup;
+    std::atomic<bool> waiting = false;
+  };
+
+  static constexpr unsigned no_worker = (std::numeric_limits<unsigned>::max)();
+
+  details::socket_resource::Handle m_listener_;
+  std::unique_ptr<std::optional<worker>[]> m_workers_;
+  std::unique_ptr<space> m_space_;
+  unsigned m_worker_count_;
+  DispatchPolicy m_policy_;
+  bool m_nonblocking_connections_;
+  unsigned m_next_ = 0;
+  //worker for each CPU, IncomingCpu policy only
+  std::vector<unsigned> m_cpu_workers_;
+
+  AcceptDispatcher(
+    details::socket_resource::Handle listener, unsigned workers, std::size_t queue_capacity,
+    DispatchPolicy policy, bool nonblocking_connections) :
+      m_listener_(listener),
+      m_workers_(std::make_unique<std::optional<worker>[]>(workers)),
+      m_space_(std::make_unique<space>()),
+      m_worker_count_(workers),
+      m_policy_(policy),
+      m_nonblocking_connections_(nonblocking_connections)
+  {
+    for(unsigned i = 0; i != workers; ++i) m_workers_[i].emplace(queue_capacity);
+  }
+
+  //connection is taken from kernel backlog only when it can be handed off,
+  //queue can only become less full from producer point of view, so check before accept is enough
+  unsigned pick_worker() noexcept
+  {
+    unsigned best = no_worker;
+
+    for(unsigned n = 0; n != m_worker_count_; ++n)
+    {
+      const unsigned i = (m_next_ + n) % m_worker_count_;
+
+      if(m_workers_[i]->queue.full()) continue;
+
+      if(m_policy_ != DispatchPolicy::LeastConnections) return i;
+
+      if(best == no_worker ||
+         m_workers_[i]->connections.load(std::memory_order_relaxed) <
+         m_workers_[best]->connections.load(std::memory_order_relaxed))
+        best = i;
+    }
+
+    return best;
+  }
+
+  //worker serving CPU which received connection, fallback when it is unknown or its queue is full
+  unsigned route(details::socket_resource::Handle h, unsigned fallback) const noexcept
+  {
+    const int cpu = details::incoming_cpu(h);
+
+    if(cpu < 0 || static_cast<std::size_t>(cpu) >= m_cpu_workers_.size()) return fallback;
+
+    const unsigned w = m_cpu_workers_[static_cast<std::size_t>(cpu)];
+
+    return w == no_worker || m_workers_[w]->queue.full() ? fallback : w;
+  }
+
+  bool all_queues_full() noexcept
+  {
+    for(unsigned i = 0; i != m_worker_count_; ++i)
+      if(!m_workers_[i]->queue.full()) return false;
+
+    return true;
+  }
+
+  //returns false on error
+  bool open_wakeups() noexcept
+  {
+    for(unsigned i = 0; i != m_worker_count_; ++i)
+      if(!m_workers_[i]->wakeup.open()) return false;
+
+    return m_space_->wakeup.open();
+  }
+
+  static bool last_error_transient() noexcept
+  {
+    //connection was reset while waiting in backlog, it is not listening socket failure
+  #if HPP_WIN_IMPL
+    return ::WSAGetLastError() == WSAECONNRESET;
+  #elif HPP_POSIX_IMPL
+    return errno == ECONNABORTED || errno == EINTR || errno == EPROTO;
+  #endif
+  }
+
+public:
+  template<auto EHP = ehl::Policy::Exception, ConnectionSettings LCS>
+  [[nodiscard]] static ehl::Result_t<AcceptDispatcher, sys_errc::ErrorCode, EHP> make(
+    const Socket<SI, inv_bind_listen, LCS>& listener, unsigned workers,
+    DispatchPolicy policy = DispatchPolicy::RoundRobin, std::size_t queue_capacity = 1024,
+    bool nonblocking_connections = false)
+      noexcept(EHP != ehl::Policy::Exception)
+  {
+    EHL_THROW_IF(workers == 0, sys_errc::ErrorCode(sys_errc::common::sockets::invalid_argument));
+
+    const auto h = details::socket_access::handle(listener);
+
+    int r = details::set_nonblocking(h, true);
+
+    EHL_THROW_IF(r != 0, sys_errc::last_error());
+
+    AcceptDispatcher d(h, workers, queue_capacity, policy, nonblocking_connections);
+
+    EHL_THROW_IF(!d.open_wakeups(), sys_errc::last_error());
+
+    return d;
+  }
+
+  unsigned worker_count() const noexcept { return m_worker_count_; }
+
+  //CPU each worker is pinned to, for IncomingCpu policy.
+  //Connections received by CPU without worker go to worker on same NUMA node
+  template<auto EHP = ehl::Policy::Exception>
+  [[nodiscard]] ehl::Result_t<void, sys_errc::ErrorCode, EHP> set_worker_cpus(std::span<const unsigned> cpus)
+    noexcept(EHP != ehl::Policy::Exception)
+  {
+    EHL_THROW_IF(cpus.size() != m_worker_count_, sys_errc::ErrorCode(sys_errc::common::sockets::invalid_argument));
+
+    std::size_t cpu_count = (std::max)(std::thread::hardware_concurrency(), 1u);
+    for(unsigned c : cpus) cpu_count = (std::max)(cpu_count, std::size_t{c} + 1);
+
+    try
+    {
+      std::vector<unsigned> worker_nodes(m_worker_count_);
+      for(unsigned w = 0; w != m_worker_count_; ++w) worker_nodes[w] = numa_node(cpus[w]);
+
+      std::vector<unsigned> cpu_workers(cpu_count, no_worker);
+
+      for(unsigned c = 0; c != cpu_count; ++c)
+      {
+        for(unsigned w = 0; w != m_worker_count_ && cpu_workers[c] == no_worker; ++w)
+          if(cpus[w] == c) cpu_workers[c] = w;
+
+        if(cpu_workers[c] != no_worker) continue;
+
+        //CPUs without worker are spread over workers of their node
+        const unsigned node = numa_node(c);
+        unsigned same_node = 0;
+
+        for(unsigned w = 0; w != m_worker_count_; ++w) same_node += worker_nodes[w] == node;
+
+        if(same_node == 0) continue;
+
+        for(unsigned w = 0, n = c % same_node; cpu_workers[c] == no_worker; ++w)
+          if(worker_nodes[w] == node && n-- == 0) cpu_workers[c] = w;
+      }
+
+      m_cpu_workers_ = std::move(cpu_workers);
+    }
+    catch(const std::bad_alloc&)
+    {
+      EHL_THROW_IF(true, sys_errc::ErrorCode(sys_errc::common::sockets::no_buffer_space));
+    }
+  }
+
+  //accepts connections until backlog is empty or all worker queues are full,
+  //returns number of dispatched connections
+  template<auto EHP = ehl::Policy::Exception>
+  [[nodiscard]] ehl::Result_t<std::size_t, sys_errc::ErrorCode, EHP> accept_pending()
+    noexcept(EHP != ehl::Policy::Exception)
+  {
+    std::size_t accepted = 0;
+
+    for(unsigned w = pick_worker(); w != no_worker; w = pick_worker())
+    {
+      details::sockaddr_type<SI.address_family> addr;
+      details::socklen_type addrlen = sizeof(addr);
+
+    #if defined(__linux__)
+      details::socket_resource s = ::accept4(
+        m_listener_, details::to_sockaddr_ptr(&addr), &addrlen,
+        SOCK_CLOEXEC | (m_nonblocking_connections_ ? SOCK_NONBLOCK : 0));
+    #else
+      details::socket_resource s = ::accept(m_listener_, details::to_sockaddr_ptr(&addr), &addrlen);
+    #endif
+
+      if(s.is_invalid())
+      {
+        if(details::last_error_would_block()) break;
+        if(last_error_transient()) continue;
+
+        EHL_THROW_IF(true, sys_errc::last_error());
+      }
+
+      if(m_policy_ == DispatchPolicy::IncomingCpu) w = route(s, w);
+
+    #if !defined(__linux__)
+      //accepted socket inherits non-blocking mode of listening socket on these platforms
+      int r = details::set_nonblocking(s, m_nonblocking_connections_);
+
+      EHL_THROW_IF(r != 0, sys_errc::last_error());
+    #endif
+
+      auto& wk = *m_workers_[w];
+
+      wk.connections.fetch_add(1, std::memory_order_relaxed);
+      wk.queue.push(connection_type{
+        details::socket_access::make<Socket<SI, inv_connect, CS>>(std::move(s)), details::from_sockaddr(addr, addrlen)});
+
+      if(!wk.signaled.exchange(true)) wk.wakeup.signal();
+
+      m_next_ = (w + 1) % m_worker_count_;
+      ++accepted;
+    }
+
+    return accepted;
+  }
+
+  //waits for incoming connections up to timeout_ms (-1 for infinite) and dispatches them,
+  //while all worker queues are full it waits for free slot instead, so it does not spin on readable listener
+  template<auto EHP = ehl::Policy::Exception>
+  [[nodiscard]] ehl::Result_t<std::size_t, sys_errc::ErrorCode, EHP> run_once(int timeout_ms)
+    noexcept(EHP != ehl::Policy::Exception)
+  {
+    pollfd fd{ .fd = m_listener_, .events = POLLIN, .revents = 0 };
+
+    if(all_queues_full())
+    {
+      m_space_->waiting.store(true);
+
+      //pairs with fence in try_pop: either worker sees waiting or slot it freed is seen here
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+
+      if(all_queues_full())
+        fd.fd = m_space_->wakeup.handle();
+      else
+        m_space_->waiting.store(false, std::memory_order_relaxed);
+    }
+
+    auto r = HPP_IFE(HPP_WIN_IMPL)(::WSAPoll)(::poll)(&fd, 1, timeout_ms);
+
+    EHL_THROW_IF(r == HPP_IFE(HPP_WIN_IMPL)(SOCKET_ERROR)(-1), sys_errc::last_error());
+
+    if(fd.fd != m_listener_)
+    {
+      m_space_->wakeup.clear();
+      m_space_->waiting.store(false, std::memory_order_relaxed);
+    }
+
+    if(r == 0) return std::size_t{0};
+
+    return accept_pending<EHP>();
+  }
+
+  //worker side, readable when connections were handed off to worker, after wakeup
+  //worker must call try_pop until it returns nothing
+  details::socket_resource::Handle wakeup_handle(unsigned worker) const noexcept
+  {
+    return m_workers_[worker]->wakeup.handle();
+  }
+
+  //worker side, takes next connection handed off to worker
+  [[nodiscard]] std::optional<connection_type> try_pop(unsigned worker) noexcept
+  {
+    auto& wk = *m_workers_[worker];
+
+    auto c = wk.queue.pop();
+
+    //wakeup is consumed before signaled flag, so connection pushed after flag is taken signals again
+    if(!c && wk.signaled.load(std::memory_order_relaxed))
+    {
+      wk.wakeup.clear();
+
+      if(wk.signaled.exchange(false)) c = wk.queue.pop();
+    }
+
+    if(c)
+    {
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+
+      if(m_space_->waiting.load(std::memory_order_relaxed) && m_space_->waiting.exchange(false))
+        m_space_->wakeup.signal();
+    }
+
+    return c;
+  }
+
+  //worker side, must be called when connection obtained from try_pop is closed
+  void release(unsigned worker) noexcept
+  {
+    m_workers_[worker]->connections.fetch_sub(1, std::memory_order_relaxed);
+  }
+
+  std::size_t connections(unsigned worker) const noexcept
+  {
+    return m_workers_[worker]->connections.load(std::memory_order_relaxed);
+  }
+};
+
+} //namespace cpps
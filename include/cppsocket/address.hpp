@@ -2,11 +2,18 @@
 
 #include "details/platform_headers.hpp"
 
+#include <algorithm>
 #include <bit>
+#include <charconv>
+#include <cstddef>
+#include <string_view>
+#include <system_error>
 #include <type_traits>
+#include <version>
 #include <strict_enum/strict_enum.hpp>
 #include <ehl/ehl.hpp>
 #include "details/ct_ip.hpp"
+#include "details/rt_ip.hpp"
 #include "details/hash_combine.hpp"
 
 namespace cpps
@@ -16,6 +23,7 @@ STRICT_ENUM(AddressFamily)
 (
   IPv4 = AF_INET,
   IPv6 = AF_INET6,
+  Unix = AF_UNIX,
 );
 
 STRICT_ENUM(AddressError)
@@ -27,7 +35,9 @@ namespace details
 {
 
 template<AddressFamily AF>
-using sockaddr_type = std::conditional_t<AF == AddressFamily::IPv4, sockaddr_in, sockaddr_in6>;
+using sockaddr_type =
+  std::conditional_t<AF == AddressFamily::IPv4, sockaddr_in,
+  std::conditional_t<AF == AddressFamily::IPv6, sockaddr_in6, sockaddr_un>>;
 
 using socklen_type = HPP_IFE(HPP_WIN_IMPL)(int)(socklen_t);
 
@@ -42,6 +52,9 @@ class Address
 
   constexpr Address(details::sockaddr_type<AF> saddr) noexcept : m_saddr_(saddr) {}
 
+  template<AddressFamily>
+  friend class Address;
+
   struct uint64_pair
   {
     std::uint64_t first, second;
@@ -71,31 +84,140 @@ public:
     }
   }
 
+  //"255.255.255.255:65535" or "[ffff:...:ffff]:65535"
+  static constexpr std::size_t max_string_size =
+    AF == AddressFamily::IPv4 ? details::ipv4_max_string_size + 6 : details::ipv6_max_string_size + 8;
+
   template<auto EHP = ehl::Policy::Exception>
-  [[nodiscard]] static ehl::Result_t<Address, AddressError, EHP> make(const char* addr, port_t port)
+  [[nodiscard]] static ehl::Result_t<Address, AddressError, EHP> make(std::string_view addr, port_t port)
     noexcept(EHP != ehl::Policy::Exception)
   {
     details::sockaddr_type<AF> saddr{};
-    int r = 0;
-
-    if constexpr(std::endian::native == std::endian::little)
-      port = std::byteswap(port);
+    bool r = false;
 
     if constexpr(AF == AddressFamily::IPv4)
     {
+      std::uint32_t a = 0;
+      r = details::rt_inet_pton4(addr, a);
+
       saddr.sin_family = AF_INET;
-      saddr.sin_port = port;
-      r = inet_pton(AF_INET, addr, &saddr.sin_addr);
+      saddr.sin_port = details::rt_hton(port);
+      saddr.sin_addr.s_addr = details::rt_hton(a);
     }
 
     if constexpr(AF == AddressFamily::IPv6)
     {
+      std::array<std::uint8_t, 16> a{};
+      r = details::rt_inet_pton6(addr, a);
+
       saddr.sin6_family = AF_INET6;
-      saddr.sin6_port = port;
-      r = inet_pton(AF_INET6, addr, &saddr.sin6_addr);
+      saddr.sin6_port = details::rt_hton(port);
+      std::ranges::copy(a, saddr.sin6_addr.s6_addr);
+    }
+
+    EHL_THROW_IF(!r, AddressError(AddressError::Invalid));
+
+    return Address(saddr);
+  }
+
+  //"a.b.c.d:port" for IPv4, "[v6]:port" for IPv6
+  template<auto EHP = ehl::Policy::Exception>
+  [[nodiscard]] static ehl::Result_t<Address, AddressError, EHP> parse(std::string_view text)
+    noexcept(EHP != ehl::Policy::Exception)
+  {
+    std::string_view host;
+    std::uint16_t port = 0;
+    bool r = false;
+
+    if constexpr(AF == AddressFamily::IPv4)
+    {
+      const std::size_t sep = text.rfind(':');
+
+      r = sep != std::string_view::npos && details::rt_parse_port(text.substr(sep + 1), port);
+      host = text.substr(0, sep);
+    }
+
+    if constexpr(AF == AddressFamily::IPv6)
+    {
+      const std::size_t sep = text.rfind("]:");
+
+      r = text.starts_with('[') && sep != std::string_view::npos && details::rt_parse_port(text.substr(sep + 2), port);
+      if(r) host = text.substr(1, sep - 1);
+    }
+
+    EHL_THROW_IF(!r, AddressError(AddressError::Invalid));
+
+    return make<EHP>(host, port);
+  }
+
+  constexpr port_t port() const noexcept
+  {
+    if constexpr(AF == AddressFamily::IPv4)
+      return details::rt_ntoh(m_saddr_.sin_port);
+    else
+      return details::rt_ntoh(m_saddr_.sin6_port);
+  }
+
+  //writes same text form as accepted by parse, without null terminator
+  constexpr std::to_chars_result to_chars(char* first, char* last) const noexcept
+  {
+    char buf[max_string_size];
+    char* p = buf;
+
+    if constexpr(AF == AddressFamily::IPv4)
+      p = details::rt_inet_ntop4(details::rt_ntoh(m_saddr_.sin_addr.s_addr), p);
+
+    if constexpr(AF == AddressFamily::IPv6)
+    {
+      std::array<std::uint8_t, 16> a{};
+      std::ranges::copy(m_saddr_.sin6_addr.s6_addr, a.begin());
+
+      *p++ = '[';
+      p = details::rt_inet_ntop6(a, p);
+      *p++ = ']';
     }
 
-    EHL_THROW_IF(r == 0, AddressError(AddressError::Invalid));
+    *p++ = ':';
+    p = details::rt_format_port(port(), p);
+
+    if(last - first < p - buf) return {last, std::errc::value_too_large};
+
+    return {std::ranges::copy(buf, p, first).out, std::errc{}};
+  }
+
+  //::ffff:a.b.c.d, how dual-stack socket sees IPv4 peers
+  constexpr bool is_ipv4_mapped() const noexcept requires (AF == AddressFamily::IPv6)
+  {
+    const auto[part1, part2] = std::bit_cast<uint64_pair>(m_saddr_.sin6_addr);
+
+    return part1 == 0 && details::rt_ntoh(part2) >> 32 == 0xFFFF;
+  }
+
+  //address must be IPv4-mapped
+  constexpr Address<AddressFamily::IPv4> to_ipv4() const noexcept requires (AF == AddressFamily::IPv6)
+  {
+    details::sockaddr_type<AddressFamily::IPv4> saddr{};
+    saddr.sin_family = AF_INET;
+    saddr.sin_port = m_saddr_.sin6_port;
+
+    std::uint32_t a = 0;
+    for(int i = 12; i != 16; ++i) a = a << 8 | m_saddr_.sin6_addr.s6_addr[i];
+    saddr.sin_addr.s_addr = details::rt_hton(a);
+
+    return Address<AddressFamily::IPv4>(saddr);
+  }
+
+  static constexpr Address from_ipv4(const Address<AddressFamily::IPv4>& addr) noexcept
+    requires (AF == AddressFamily::IPv6)
+  {
+    details::sockaddr_type<AddressFamily::IPv6> saddr{};
+    saddr.sin6_family = AF_INET6;
+    saddr.sin6_port = addr.m_saddr_.sin_port;
+
+    const std::uint32_t a = details::rt_ntoh(addr.m_saddr_.sin_addr.s_addr);
+    saddr.sin6_addr.s6_addr[10] = 0xFF;
+    saddr.sin6_addr.s6_addr[11] = 0xFF;
+    for(int i = 0; i != 4; ++i) saddr.sin6_addr.s6_addr[12 + i] = static_cast<std::uint8_t>(a >> (24 - 8 * i));
 
     return Address(saddr);
   }
@@ -141,6 +263,121 @@ public:
 using AddressIPv4 = Address<AddressFamily::IPv4>;
 using AddressIPv6 = Address<AddressFamily::IPv6>;
 
+template<>
+class Address<AddressFamily::Unix>;
+
+namespace details
+{
+
+inline Address<AddressFamily::Unix> from_sockaddr(const sockaddr_type<AddressFamily::Unix>& s, socklen_type len) noexcept;
+
+} //namespace details
+
+//Unix domain socket address: filesystem path, abstract name (Linux) or unnamed
+template<>
+class Address<AddressFamily::Unix>
+{
+  static constexpr std::size_t path_offset = offsetof(details::sockaddr_type<AddressFamily::Unix>, sun_path);
+  static constexpr std::size_t max_path_size = sizeof(details::sockaddr_type<AddressFamily::Unix>::sun_path);
+
+  details::sockaddr_type<AddressFamily::Unix> m_saddr_;
+  details::socklen_type m_len_;
+
+  constexpr Address(details::sockaddr_type<AddressFamily::Unix> saddr, details::socklen_type len) noexcept :
+    m_saddr_(saddr), m_len_(len) {}
+
+  friend Address details::from_sockaddr(const details::sockaddr_type<AddressFamily::Unix>&, details::socklen_type) noexcept;
+
+public:
+  template<std::size_t N>
+  consteval Address(const char (&path)[N]) noexcept : m_saddr_{}, m_len_(path_offset + N)
+  {
+    static_assert(N > 1 && N <= max_path_size, "Invalid unix socket path length");
+
+    m_saddr_.sun_family = AF_UNIX;
+    for(std::size_t i = 0; i != N; ++i) m_saddr_.sun_path[i] = path[i];
+  }
+
+  template<auto EHP = ehl::Policy::Exception>
+  [[nodiscard]] static ehl::Result_t<Address, AddressError, EHP> make(std::string_view path)
+    noexcept(EHP != ehl::Policy::Exception)
+  {
+    //path must be null terminated inside sun_path
+    EHL_THROW_IF(
+      path.empty() || path.size() >= max_path_size || path.find('\0') != std::string_view::npos,
+      AddressError(AddressError::Invalid));
+
+    details::sockaddr_type<AddressFamily::Unix> saddr{};
+    saddr.sun_family = AF_UNIX;
+    path.copy(saddr.sun_path, path.size());
+
+    return Address(saddr, static_cast<details::socklen_type>(path_offset + path.size() + 1));
+  }
+
+#if defined(__linux__)
+  //abstract namespace address, not bound to filesystem and removed with last socket referring to it
+  template<auto EHP = ehl::Policy::Exception>
+  [[nodiscard]] static ehl::Result_t<Address, AddressError, EHP> make_abstract(std::string_view name)
+    noexcept(EHP != ehl::Policy::Exception)
+  {
+    EHL_THROW_IF(name.size() >= max_path_size, AddressError(AddressError::Invalid));
+
+    details::sockaddr_type<AddressFamily::Unix> saddr{};
+    saddr.sun_family = AF_UNIX;
+    name.copy(saddr.sun_path + 1, name.size());
+
+    return Address(saddr, static_cast<details::socklen_type>(path_offset + 1 + name.size()));
+  }
+#endif
+
+  constexpr bool is_unnamed() const noexcept
+  {
+    return static_cast<std::size_t>(m_len_) <= path_offset;
+  }
+
+  constexpr bool is_abstract() const noexcept
+  {
+    return !is_unnamed() && m_saddr_.sun_path[0] == '\0';
+  }
+
+  //filesystem path or abstract name without leading null character
+  constexpr std::string_view path() const noexcept
+  {
+    if(is_unnamed()) return {};
+
+    if(is_abstract())
+      return std::string_view(m_saddr_.sun_path + 1, static_cast<std::size_t>(m_len_) - path_offset - 1);
+
+    //filesystem path length given by kernel can include terminating null
+    const std::string_view p(m_saddr_.sun_path, static_cast<std::size_t>(m_len_) - path_offset);
+
+    return p.substr(0, p.find('\0'));
+  }
+
+  constexpr details::socklen_type length() const noexcept { return m_len_; }
+
+  constexpr bool operator==(const Address& addr) const noexcept
+  {
+    return is_abstract() == addr.is_abstract() && path() == addr.path();
+  }
+
+  constexpr bool operator!=(const Address& addr) const noexcept
+  {
+    return !this->operator==(addr);
+  }
+
+  std::size_t hash() const noexcept
+  {
+    std::size_t seed = std::hash<std::string_view>{}(path());
+
+    details::hash_combine(seed, is_abstract());
+
+    return seed;
+  }
+};
+
+using AddressUnix = Address<AddressFamily::Unix>;
+
 namespace details
 {
 
@@ -148,8 +385,10 @@ template<typename T>
   requires (
     std::is_pointer_interconvertible_base_of_v<sockaddr_type<AddressFamily::IPv4>, T> ||
     std::is_pointer_interconvertible_base_of_v<sockaddr_type<AddressFamily::IPv6>, T> ||
+    std::is_pointer_interconvertible_base_of_v<sockaddr_type<AddressFamily::Unix>, T> ||
     std::is_same_v<Address<AddressFamily::IPv4>, std::remove_cv_t<T>>                 ||
-    std::is_same_v<Address<AddressFamily::IPv6>, std::remove_cv_t<T>>)
+    std::is_same_v<Address<AddressFamily::IPv6>, std::remove_cv_t<T>>                 ||
+    std::is_same_v<Address<AddressFamily::Unix>, std::remove_cv_t<T>>)
 inline auto to_sockaddr_ptr(T* addr) noexcept
 {
   //getting pointer by reinterpret_cast is not UB,
@@ -158,16 +397,31 @@ inline auto to_sockaddr_ptr(T* addr) noexcept
   return reinterpret_cast<std::conditional_t<std::is_const_v<T>, const sockaddr*, sockaddr*>>(addr);
 }
 
-inline Address<AddressFamily::IPv4> from_sockaddr(const sockaddr_type<AddressFamily::IPv4>& s) noexcept
+inline Address<AddressFamily::IPv4> from_sockaddr(const sockaddr_type<AddressFamily::IPv4>& s, socklen_type = 0) noexcept
 {
   return std::bit_cast<Address<AddressFamily::IPv4>>(s);
 }
 
-inline Address<AddressFamily::IPv6> from_sockaddr(const sockaddr_type<AddressFamily::IPv6>& s) noexcept
+inline Address<AddressFamily::IPv6> from_sockaddr(const sockaddr_type<AddressFamily::IPv6>& s, socklen_type = 0) noexcept
 {
   return std::bit_cast<Address<AddressFamily::IPv6>>(s);
 }
 
+inline Address<AddressFamily::Unix> from_sockaddr(const sockaddr_type<AddressFamily::Unix>& s, socklen_type len) noexcept
+{
+  return Address<AddressFamily::Unix>(s, len);
+}
+
+//length of socket address passed to bind/connect/sendto
+template<AddressFamily AF>
+constexpr socklen_type sockaddr_length(const Address<AF>& addr) noexcept
+{
+  if constexpr(AF == AddressFamily::Unix)
+    return addr.length();
+  else
+    return sizeof(addr);
+}
+
 } //namespace details
 
 } //namespace cpps
@@ -180,3 +434,27 @@ struct std::hash<cpps::Address<AF>>
     return s.hash();
   }
 };
+
+#if defined(__cpp_lib_format)
+#include <format>
+
+template<cpps::AddressFamily AF> requires (AF != cpps::AddressFamily::Unix)
+struct std::formatter<cpps::Address<AF>, char>
+{
+  constexpr auto parse(std::format_parse_context& ctx)
+  {
+    if(ctx.begin() != ctx.end() && *ctx.begin() != '}')
+      throw std::format_error("Address does not support format specifiers");
+
+    return ctx.begin();
+  }
+
+  auto format(const cpps::Address<AF>& addr, std::format_context& ctx) const
+  {
+    char buf[cpps::Address<AF>::max_string_size];
+    const auto r = addr.to_chars(buf, buf + sizeof(buf));
+
+    return std::ranges::copy(buf, r.ptr, ctx.out()).out;
+  }
+};
+#endif
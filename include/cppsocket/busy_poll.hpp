@@ -0,0 +1,194 @@
+#pragma once
+
+#include "details/platform_headers.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include "socket.hpp"
+#include "details/cpu_relax.hpp"
+#include "details/nonblocking.hpp"
+#include "details/socket_access.hpp"
+
+namespace cpps
+{
+
+struct BusyPollSettings
+{
+  //upper bound of spinning before receive blocks, adapted spin never exceeds it
+  std::chrono::nanoseconds max_spin = std::chrono::microseconds(50);
+
+  //microseconds kernel polls device queue on receive (SO_BUSY_POLL, Linux), 0 leaves socket default.
+  //Values above net.core.busy_read need CAP_NET_ADMIN
+  unsigned kernel_busy_poll_us = 0;
+
+  //device interrupts stay deferred while application busy polls (SO_PREFER_BUSY_POLL, Linux 5.11),
+  //effective only with napi_defer_hard_irqs and gro_flush_timeout of device set, ignored where unsupported
+  bool prefer_busy_poll = false;
+};
+
+struct BusyPollStats
+{
+  //packets found while spinning
+  std::uint64_t spun = 0;
+  //packets received after spin budget was spent
+  std::uint64_t blocked = 0;
+};
+
+//Receives from datagram socket spinning on non-blocking peeks before falling back to blocking receive,
+//so packets arriving shortly after call are taken without wakeup latency of blocked thread.
+//Spin budget follows average wait for packet: it covers twice that wait, so most packets arriving
+//at steady rate are caught spinning, and drops to zero when average wait exceeds max_spin,
+//so idle sockets cost no CPU. Meant for dedicated cores.
+//Socket must outlive BusyPollReceiver. Not thread safe
+template<SocketInfo SI, InvInfo INV, ConnectionSettings SCS>
+  requires (SI.type == SocketType::Datagram)
+class BusyPollReceiver
+{
+  using clock_type = std::chrono::steady_clock;
+
+  template<typename T>
+  using recvfrom_result = typename Socket<SI, INV, SCS>::template recvfrom_result<T>;
+
+  //peeks are issued in between this many spin hints
+  static constexpr unsigned relax_count = 16;
+
+  Socket<SI, INV, SCS>& m_sock_;
+  std::chrono::nanoseconds m_max_spin_;
+  //exponentially weighted average of time from receive call to packet arrival
+  std::chrono::nanoseconds m_average_wait_ = std::chrono::nanoseconds(0);
+  BusyPollStats m_stats_;
+
+  BusyPollReceiver(Socket<SI, INV, SCS>& sock, std::chrono::nanoseconds max_spin) noexcept :
+    m_sock_(sock), m_max_spin_(max_spin) {}
+
+  //datagram or pending error is queued
+  bool ready() const noexcept
+  {
+    const auto h = details::socket_access::handle(m_sock_);
+
+#if HPP_WIN_IMPL
+    pollfd fd{ .fd = h, .events = POLLIN, .revents = 0 };
+
+    return ::WSAPoll(&fd, 1, 0) != 0;
+#else
+    char c;
+
+    return ::recv(h, &c, 1, MSG_PEEK | MSG_DONTWAIT) >= 0 || !details::last_error_would_block();
+#endif
+  }
+
+  //returns true when datagram arrived within spin budget
+  bool spin(clock_type::time_point start) const noexcept
+  {
+    const auto budget = spin_budget();
+
+    if(budget.count() == 0) return false;
+
+    for(;;)
+    {
+      if(ready()) return true;
+      if(clock_type::now() - start >= budget) return false;
+
+      for(unsigned i = 0; i != relax_count; ++i) details::cpu_relax();
+    }
+  }
+
+  void observe(clock_type::time_point start, bool spun) noexcept
+  {
+    const auto wait = std::chrono::duration_cast<std::chrono::nanoseconds>(clock_type::now() - start);
+
+    m_average_wait_ += (wait - m_average_wait_) / 8;
+
+    ++(spun ? m_stats_.spun : m_stats_.blocked);
+  }
+
+public:
+  template<auto EHP = ehl::Policy::Exception>
+  [[nodiscard]] static ehl::Result_t<BusyPollReceiver, sys_errc::ErrorCode, EHP> make(
+    Socket<SI, INV, SCS>& sock, const BusyPollSettings& settings = {})
+      noexcept(EHP != ehl::Policy::Exception)
+  {
+    [[maybe_unused]] const auto h = details::socket_access::handle(sock);
+
+#if defined(SO_BUSY_POLL)
+    if(settings.kernel_busy_poll_us != 0)
+    {
+      const int us = static_cast<int>(settings.kernel_busy_poll_us);
+      int r = ::setsockopt(h, SOL_SOCKET, SO_BUSY_POLL, &us, sizeof(us));
+
+      EHL_THROW_IF(r != 0, sys_errc::last_error());
+    }
+#endif
+
+#if defined(SO_PREFER_BUSY_POLL)
+    if(settings.prefer_busy_poll)
+    {
+      const int enable = 1;
+      int r = ::setsockopt(h, SOL_SOCKET, SO_PREFER_BUSY_POLL, &enable, sizeof(enable));
+
+      EHL_THROW_IF(r != 0, sys_errc::last_error());
+    }
+#endif
+
+    return BusyPollReceiver(sock, settings.max_spin);
+  }
+
+  template<typename T, ConnectionSettings CS = default_connection_settings, auto EHP = ehl::Policy::Exception>
+    requires (packet_type<T> || packet_variant_type<T>)
+  [[nodiscard]] ehl::Result_t<recvfrom_result<T>, sys_errc::ErrorCode, EHP> recvfrom()
+    noexcept(EHP != ehl::Policy::Exception)
+  {
+    const auto start = clock_type::now();
+    const bool spun = spin(start);
+
+    auto r = m_sock_.template recvfrom<T, CS, EHP>();
+
+    observe(start, spun);
+
+    return r;
+  }
+
+  template<packet_type T, auto EHP = ehl::Policy::Exception> requires (INV.connected)
+  [[nodiscard]] ehl::Result_t<valid_packet<T>, sys_errc::ErrorCode, EHP> recv()
+    noexcept(EHP != ehl::Policy::Exception)
+  {
+    const auto start = clock_type::now();
+    const bool spun = spin(start);
+
+    auto r = m_sock_.template recv<T, EHP>();
+
+    observe(start, spun);
+
+    return r;
+  }
+
+  template<packet_variant_type V, auto EHP = ehl::Policy::Exception> requires (INV.connected)
+  [[nodiscard]] ehl::Result_t<valid_packet_variant<V>, sys_errc::ErrorCode, EHP> recv()
+    noexcept(EHP != ehl::Policy::Exception)
+  {
+    const auto start = clock_type::now();
+    const bool spun = spin(start);
+
+    auto r = m_sock_.template recv<V, EHP>();
+
+    observe(start, spun);
+
+    return r;
+  }
+
+  //time next receive spins before blocking
+  std::chrono::nanoseconds spin_budget() const noexcept
+  {
+    if(m_average_wait_ > m_max_spin_) return std::chrono::nanoseconds(0);
+
+    return (std::min)(2 * m_average_wait_, m_max_spin_);
+  }
+
+  const BusyPollStats& stats() const noexcept
+  {
+    return m_stats_;
+  }
+};
+
+} //namespace cpps
@@ -0,0 +1,481 @@
+#pragma once
+
+#include "details/platform_headers.hpp"
+
+#if HPP_POSIX_IMPL
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <optional>
+#include <span>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "socket.hpp"
+#include "loopback.hpp"
+#include "details/socket_access.hpp"
+
+namespace cpps
+{
+
+namespace details
+{
+
+//capture file: header followed by records, integers in byte order of recording host
+struct capture_header
+{
+  static constexpr std::uint64_t magic_value = 0x6370707363617031; //"cppscap1"
+
+  std::atomic<std::uint64_t> magic;
+  std::uint32_t address_family;
+  std::uint32_t reserved;
+  //bytes of records, record is visible to readers once it is covered by size
+  std::atomic<std::uint64_t> size;
+};
+
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free);
+
+//record: this header followed by payload, padded to 8 bytes
+template<AddressFamily AF>
+struct capture_record_header
+{
+  //wall clock time of receipt in nanoseconds
+  std::uint64_t timestamp_ns;
+  std::uint32_t size;
+  std::uint32_t addrlen;
+  sockaddr_type<AF> addr;
+};
+
+template<AddressFamily AF>
+constexpr std::size_t capture_record_size(std::size_t payload) noexcept
+{
+  return (sizeof(capture_record_header<AF>) + payload + 7) & ~std::size_t{7};
+}
+
+//true when size bytes of records at data hold whole records with addresses of AF
+template<AddressFamily AF>
+bool valid_capture_records(const std::byte* data, std::size_t size) noexcept
+{
+  for(std::size_t pos = 0; pos != size;)
+  {
+    if(size - pos < sizeof(capture_record_header<AF>)) return false;
+
+    capture_record_header<AF> h;
+    std::memcpy(&h, data + pos, sizeof(h));
+
+    if(h.addrlen > sizeof(sockaddr_type<AF>) || capture_record_size<AF>(h.size) > size - pos) return false;
+
+    pos += capture_record_size<AF>(h.size);
+  }
+
+  return true;
+}
+
+inline std::uint64_t capture_timestamp() noexcept
+{
+  return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::system_clock::now().time_since_epoch()).count());
+}
+
+} //namespace details
+
+//Appends received datagrams (raw wire bytes, size, timestamp and sender address) to memory mapped capture file.
+//File grows by doubling and is trimmed to recorded size when recorder is destroyed,
+//records are published by size in header, so file can be replayed while it is being recorded.
+//Not thread safe
+template<AddressFamily AF>
+class Recorder
+{
+  static constexpr sys_errc::ErrorCode invalid_argument_err = sys_errc::common::sockets::invalid_argument;
+
+  //largest datagram recorded in full, longer ones (unix domain only) are truncated
+  static constexpr std::size_t max_datagram_size = 65536;
+
+  details::capture_header* m_header_ = nullptr;
+  std::size_t m_mapping_size_ = 0;
+  int m_fd_ = -1;
+  std::vector<std::byte> m_buffer_;
+
+  Recorder(details::capture_header* header, std::size_t mapping_size, int fd) :
+    m_header_(header), m_mapping_size_(mapping_size), m_fd_(fd), m_buffer_(max_datagram_size) {}
+
+  std::byte* records() const noexcept
+  {
+    return reinterpret_cast<std::byte*>(m_header_ + 1);
+  }
+
+  //remaps file so it can hold size bytes, returns false on error
+  bool reserve(std::size_t size) noexcept
+  {
+    if(size <= m_mapping_size_) return true;
+
+    const std::size_t new_size = std::bit_ceil(size);
+
+    if(::ftruncate(m_fd_, static_cast<off_t>(new_size)) != 0) return false;
+
+#if defined(__linux__)
+    void* p = ::mremap(m_header_, m_mapping_size_, new_size, MREMAP_MAYMOVE);
+#else
+    void* p = ::mmap(nullptr, new_size, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd_, 0);
+    if(p != MAP_FAILED) ::munmap(m_header_, m_mapping_size_);
+#endif
+
+    if(p == MAP_FAILED) return false;
+
+    m_header_ = static_cast<details::capture_header*>(p);
+    m_mapping_size_ = new_size;
+
+    return true;
+  }
+
+  //appends record, returns false when file can not grow
+  bool write(std::span<const std::byte> data, const Address<AF>& from, std::uint64_t timestamp_ns) noexcept
+  {
+    const std::uint64_t offset = m_header_->size.load(std::memory_order_relaxed);
+    const std::size_t record_size = details::capture_record_size<AF>(data.size());
+
+    if(!reserve(sizeof(details::capture_header) + offset + record_size)) return false;
+
+    details::capture_record_header<AF> hdr{};
+    hdr.timestamp_ns = timestamp_ns;
+    hdr.size = static_cast<std::uint32_t>(data.size());
+    hdr.addrlen = static_cast<std::uint32_t>(details::sockaddr_length(from));
+    std::memcpy(&hdr.addr, details::to_sockaddr_ptr(&from), hdr.addrlen);
+
+    std::byte* rec = records() + offset;
+    std::memcpy(rec, &hdr, sizeof(hdr));
+    if(!data.empty()) std::memcpy(rec + sizeof(hdr), data.data(), data.size());
+
+    m_header_->size.store(offset + record_size, std::memory_order_release);
+
+    return true;
+  }
+
+public:
+  //creates or truncates capture file
+  template<auto EHP = ehl::Policy::Exception>
+  [[nodiscard]] static ehl::Result_t<Recorder, sys_errc::ErrorCode, EHP> make(
+    const char* path, std::size_t initial_size = std::size_t{1} << 20)
+      noexcept(EHP != ehl::Policy::Exception)
+  {
+    int fd = ::open(path, O_CREAT | O_TRUNC | O_RDWR | O_CLOEXEC, 0644);
+
+    EHL_THROW_IF(fd < 0, sys_errc::last_error());
+
+    const std::size_t size = std::bit_ceil((std::max)(initial_size, std::size_t{4096}));
+
+    int r = ::ftruncate(fd, static_cast<off_t>(size));
+    void* p = r == 0 ? ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+
+    if(p == MAP_FAILED)
+    {
+      const auto err = sys_errc::last_error();
+      ::close(fd);
+
+      EHL_THROW_IF(true, err);
+    }
+
+    auto* header = ::new(p) details::capture_header{};
+    header->address_family = static_cast<std::uint32_t>(AF);
+    header->magic.store(details::capture_header::magic_value, std::memory_order_release);
+
+    return Recorder(header, size, fd);
+  }
+
+  Recorder(Recorder&& r) noexcept :
+    m_header_(std::exchange(r.m_header_, nullptr)),
+    m_mapping_size_(r.m_mapping_size_),
+    m_fd_(std::exchange(r.m_fd_, -1)),
+    m_buffer_(std::move(r.m_buffer_)) {}
+
+  Recorder& operator=(Recorder&& r) noexcept
+  {
+    Recorder tmp(std::move(r));
+
+    std::swap(m_header_, tmp.m_header_);
+    std::swap(m_mapping_size_, tmp.m_mapping_size_);
+    std::swap(m_fd_, tmp.m_fd_);
+    std::swap(m_buffer_, tmp.m_buffer_);
+
+    return *this;
+  }
+
+  ~Recorder()
+  {
+    if(m_header_)
+    {
+      const auto size = sizeof(details::capture_header) + m_header_->size.load(std::memory_order_relaxed);
+
+      ::munmap(m_header_, m_mapping_size_);
+      [[maybe_unused]] int r = ::ftruncate(m_fd_, static_cast<off_t>(size));
+    }
+
+    if(m_fd_ >= 0) ::close(m_fd_);
+  }
+
+  //bytes of recorded records
+  std::uint64_t size() const noexcept { return m_header_->size.load(std::memory_order_relaxed); }
+
+  //Appends datagram received from sender
+  template<auto EHP = ehl::Policy::Exception>
+  [[nodiscard]] ehl::Result_t<void, sys_errc::ErrorCode, EHP> append(
+    std::span<const std::byte> data, const Address<AF>& from, std::uint64_t timestamp_ns = details::capture_timestamp())
+      noexcept(EHP != ehl::Policy::Exception)
+  {
+    EHL_THROW_IF(data.size() > max_datagram_size, invalid_argument_err);
+    EHL_THROW_IF(!write(data, from, timestamp_ns), sys_errc::last_error());
+  }
+
+  //Waits for next datagram of sock and records it without consuming it (MSG_PEEK),
+  //so socket receives it afterwards as usual; returns size of datagram
+  template<auto EHP = ehl::Policy::Exception, SocketInfo SI, InvInfo INV, ConnectionSettings SCS>
+    requires (SI.address_family == AF && SI.type != SocketType::Stream)
+  [[nodiscard]] ehl::Result_t<std::size_t, sys_errc::ErrorCode, EHP> record(Socket<SI, INV, SCS>& sock)
+    noexcept(EHP != ehl::Policy::Exception)
+  {
+    details::sockaddr_type<AF> addr{};
+    details::socklen_type addrlen = sizeof(addr);
+
+    auto r = ::recvfrom(
+      details::socket_access::handle(sock), reinterpret_cast<char*>(m_buffer_.data()), m_buffer_.size(), MSG_PEEK,
+      details::to_sockaddr_ptr(&addr), &addrlen);
+
+    EHL_THROW_IF(r < 0, sys_errc::last_error());
+
+    const auto size = static_cast<std::size_t>(r);
+
+    EHL_THROW_IF(
+      !write(std::span{m_buffer_.data(), size}, details::from_sockaddr(addr, addrlen), details::capture_timestamp()),
+      sys_errc::last_error());
+
+    return size;
+  }
+};
+
+//Reads capture file made by Recorder and replays it into server
+template<AddressFamily AF>
+class Replayer
+{
+  static constexpr sys_errc::ErrorCode invalid_argument_err = sys_errc::common::sockets::invalid_argument;
+
+  const std::byte* m_data_ = nullptr;
+  std::size_t m_mapping_size_ = 0;
+  //bytes of records checked on open
+  std::size_t m_size_ = 0;
+
+  Replayer(const std::byte* data, std::size_t mapping_size) noexcept :
+    m_data_(data), m_mapping_size_(mapping_size) {}
+
+  const details::capture_header& header() const noexcept
+  {
+    return *reinterpret_cast<const details::capture_header*>(m_data_);
+  }
+
+  //sleeps until time of record scaled by speed, 0 does not wait
+  struct pacer
+  {
+    double speed;
+    std::uint64_t first_ns = 0;
+    std::chrono::steady_clock::time_point start{};
+    bool started = false;
+
+    void wait(std::uint64_t timestamp_ns) noexcept
+    {
+      if(speed <= 0) return;
+
+      if(!std::exchange(started, true))
+      {
+        first_ns = timestamp_ns;
+        start = std::chrono::steady_clock::now();
+        return;
+      }
+
+      const auto offset = static_cast<double>(timestamp_ns - (std::min)(timestamp_ns, first_ns)) / speed;
+      std::this_thread::sleep_until(start + std::chrono::nanoseconds(static_cast<std::int64_t>(offset)));
+    }
+  };
+
+public:
+  struct record
+  {
+    std::uint64_t timestamp_ns;
+    Address<AF> from;
+    std::span<const std::byte> data;
+  };
+
+  class iterator
+  {
+    const std::byte* m_pos_ = nullptr;
+
+    friend class Replayer;
+
+    explicit iterator(const std::byte* pos) noexcept : m_pos_(pos) {}
+
+    const details::capture_record_header<AF>& hdr() const noexcept
+    {
+      return *reinterpret_cast<const details::capture_record_header<AF>*>(m_pos_);
+    }
+
+  public:
+    using value_type = record;
+    using difference_type = std::ptrdiff_t;
+
+    iterator() noexcept = default;
+
+    record operator*() const noexcept
+    {
+      const auto& h = hdr();
+
+      return {
+        h.timestamp_ns,
+        details::from_sockaddr(h.addr, static_cast<details::socklen_type>(h.addrlen)),
+        {m_pos_ + sizeof(h), h.size}};
+    }
+
+    iterator& operator++() noexcept
+    {
+      m_pos_ += details::capture_record_size<AF>(hdr().size);
+      return *this;
+    }
+
+    iterator operator++(int) noexcept
+    {
+      iterator it = *this;
+      ++*this;
+      return it;
+    }
+
+    bool operator==(const iterator&) const noexcept = default;
+  };
+
+  //Maps capture file, records appended afterwards are not seen.
+  //Fails with invalid_argument unless every record lies within file and has address of AF
+  template<auto EHP = ehl::Policy::Exception>
+  [[nodiscard]] static ehl::Result_t<Replayer, sys_errc::ErrorCode, EHP> open(const char* path)
+    noexcept(EHP != ehl::Policy::Exception)
+  {
+    int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+
+    EHL_THROW_IF(fd < 0, sys_errc::last_error());
+
+    struct stat st;
+    int r = ::fstat(fd, &st);
+    const auto size = r == 0 ? static_cast<std::size_t>(st.st_size) : 0;
+
+    void* p = r == 0 && size >= sizeof(details::capture_header) ?
+      ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+
+    const auto err = r != 0 || p == MAP_FAILED ? sys_errc::last_error() : sys_errc::ErrorCode(invalid_argument_err);
+    ::close(fd);
+
+    EHL_THROW_IF(r != 0, err);
+    EHL_THROW_IF(size < sizeof(details::capture_header), invalid_argument_err);
+    EHL_THROW_IF(p == MAP_FAILED, err);
+
+    Replayer replayer(static_cast<const std::byte*>(p), size);
+    const auto& h = replayer.header();
+
+    EHL_THROW_IF(
+      h.magic.load(std::memory_order_acquire) != details::capture_header::magic_value ||
+      h.address_family != static_cast<std::uint32_t>(AF),
+      invalid_argument_err);
+
+    replayer.m_size_ = h.size.load(std::memory_order_acquire);
+
+    EHL_THROW_IF(
+      replayer.m_size_ > size - sizeof(details::capture_header) ||
+      !details::valid_capture_records<AF>(replayer.m_data_ + sizeof(details::capture_header), replayer.m_size_),
+      invalid_argument_err);
+
+    return replayer;
+  }
+
+  Replayer(Replayer&& r) noexcept :
+    m_data_(std::exchange(r.m_data_, nullptr)), m_mapping_size_(r.m_mapping_size_), m_size_(r.m_size_) {}
+
+  Replayer& operator=(Replayer&& r) noexcept
+  {
+    Replayer tmp(std::move(r));
+
+    std::swap(m_data_, tmp.m_data_);
+    std::swap(m_mapping_size_, tmp.m_mapping_size_);
+    std::swap(m_size_, tmp.m_size_);
+
+    return *this;
+  }
+
+  ~Replayer()
+  {
+    if(m_data_) ::munmap(const_cast<std::byte*>(m_data_), m_mapping_size_);
+  }
+
+  iterator begin() const noexcept
+  {
+    return iterator(m_data_ + sizeof(details::capture_header));
+  }
+
+  iterator end() const noexcept
+  {
+    return iterator(m_data_ + sizeof(details::capture_header) + m_size_);
+  }
+
+  //Sends recorded datagrams from sock to dest, gaps between them are divided by speed (2 is twice faster),
+  //0 sends them back to back; returns number of sent datagrams
+  template<auto EHP = ehl::Policy::Exception, SocketInfo SI, InvInfo INV, ConnectionSettings SCS>
+    requires (SI.address_family == AF && SI.type == SocketType::Datagram)
+  [[nodiscard]] ehl::Result_t<std::size_t, sys_errc::ErrorCode, EHP> replay(
+    Socket<SI, INV, SCS>& sock, const Address<AF>& dest, double speed = 1)
+      noexcept(EHP != ehl::Policy::Exception)
+  {
+    pacer p{speed};
+    std::size_t sent = 0;
+
+    for(const record r : *this)
+    {
+      p.wait(r.timestamp_ns);
+
+      auto res = ::sendto(
+        details::socket_access::handle(sock), reinterpret_cast<const char*>(r.data.data()), r.data.size(), 0,
+        details::to_sockaddr_ptr(&dest), details::sockaddr_length(dest));
+
+      EHL_THROW_IF(res < 0, sys_errc::last_error());
+
+      ++sent;
+    }
+
+    return sent;
+  }
+
+  //Injects recorded datagrams into simulated network as sent by their recorded senders,
+  //virtual clock is advanced by gaps between them divided by speed; returns number of injected datagrams
+  std::size_t replay(LoopbackNetwork<AF>& net, const Address<AF>& dest, double speed = 1)
+  {
+    std::optional<std::uint64_t> prev;
+    std::size_t injected = 0;
+
+    for(const record r : *this)
+    {
+      if(prev && speed > 0 && r.timestamp_ns > *prev)
+        net.advance(static_cast<std::uint64_t>(static_cast<double>(r.timestamp_ns - *prev) / speed));
+
+      prev = r.timestamp_ns;
+
+      net.inject(r.from, dest, r.data);
+      ++injected;
+    }
+
+    return injected;
+  }
+};
+
+} //namespace cpps
+
+#endif
@@ -0,0 +1,266 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "socket.hpp"
+#include "details/configure.hpp"
+#include "details/socket_access.hpp"
+#include "details/spsc_queue.hpp"
+
+namespace cpps
+{
+
+struct PoolSettings
+{
+  //idle connections kept for one address
+  std::size_t max_idle_per_address = 8;
+
+  //idle connections kept for all addresses
+  std::size_t max_idle = 1024;
+
+  //idle connection older than this is closed instead of reused
+  std::chrono::milliseconds idle_timeout = std::chrono::seconds(30);
+};
+
+//Pool of connected stream sockets keyed by destination address.
+//Idle connections are kept per address in mutex protected shards, so leases for different
+//addresses rarely contend; most recently returned connection is reused first.
+//Before reuse connection is checked with zero timeout poll for input:
+//idle connection must not be readable, otherwise peer has closed it or sent unexpected data.
+//Pool must outlive its leases.
+template<SocketInfo SI, ConnectionSettings SCS = default_connection_settings, std::size_t Shards = 16>
+  requires (SI.type != SocketType::Datagram && Shards != 0)
+class ConnectionPool
+{
+public:
+  using socket_type = Socket<SI, inv_connect, SCS>;
+  using address_type = Address<SI.address_family>;
+
+  //Connection taken from pool, returned back on destruction
+  class Lease
+  {
+  public:
+    Lease(Lease&& l) noexcept :
+      m_pool_(std::exchange(l.m_pool_, nullptr)),
+      m_addr_(l.m_addr_),
+      m_sock_(std::move(l.m_sock_)),
+      m_reused_(l.m_reused_) {}
+
+    Lease& operator=(Lease&& l) noexcept
+    {
+      if(&l != this)
+      {
+        give_back();
+
+        m_pool_ = std::exchange(l.m_pool_, nullptr);
+        m_addr_ = l.m_addr_;
+        m_sock_ = std::move(l.m_sock_);
+        m_reused_ = l.m_reused_;
+      }
+
+      return *this;
+    }
+
+    ~Lease() { give_back(); }
+
+    socket_type& operator*() noexcept { return *m_sock_; }
+    socket_type* operator->() noexcept { return &*m_sock_; }
+
+    const address_type& address() const noexcept { return m_addr_; }
+
+    //true when connection was taken from pool instead of being established
+    bool reused() const noexcept { return m_reused_; }
+
+    //Connection state is unknown after failed send/recv, close it instead of returning to pool
+    void discard() noexcept { m_sock_.reset(); }
+
+  private:
+    friend class ConnectionPool;
+
+    Lease(ConnectionPool* pool, const address_type& addr, socket_type&& sock, bool reused) noexcept :
+      m_pool_(pool), m_addr_(addr), m_sock_(std::move(sock)), m_reused_(reused) {}
+
+    void give_back() noexcept
+    {
+      if(m_pool_ && m_sock_) m_pool_->give_back(m_addr_, std::move(*m_sock_));
+
+      m_sock_.reset();
+    }
+
+    ConnectionPool* m_pool_;
+    address_type m_addr_;
+    std::optional<socket_type> m_sock_;
+    bool m_reused_;
+  };
+
+  explicit ConnectionPool(const PoolSettings& settings = {}) : m_settings_(settings) {}
+
+  ConnectionPool(const ConnectionPool&) = delete;
+  ConnectionPool& operator=(const ConnectionPool&) = delete;
+
+  //Healthy idle connection to addr or new one
+  template<auto EHP = ehl::Policy::Exception>
+  [[nodiscard]] ehl::Result_t<Lease, sys_errc::ErrorCode, EHP> lease(const address_type& addr)
+    noexcept(EHP != ehl::Policy::Exception)
+  {
+    if(auto sock = take_idle(addr)) return Lease(this, addr, std::move(*sock), true);
+
+    details::socket_resource sfd = ::socket((int)SI.address_family, (int)SI.type, (int)SI.protocol);
+
+    EHL_THROW_IF(sfd.is_invalid(), sys_errc::last_error());
+
+    int r = details::configure<SI>(sfd);
+
+    EHL_THROW_IF(r != 0, sys_errc::last_error());
+
+    r = ::connect(sfd, details::to_sockaddr_ptr(&addr), details::sockaddr_length(addr));
+
+    EHL_THROW_IF(r != 0, sys_errc::last_error());
+
+    auto sock = details::socket_access::make<socket_type>(std::move(sfd));
+
+    if constexpr(SCS.negotiate_byte_order)
+    {
+      const auto err = details::socket_access::exchange_hello(sock);
+
+      EHL_THROW_IF(err.has_value(), *err);
+    }
+
+    return Lease(this, addr, std::move(sock), false);
+  }
+
+  //Closes idle connections older than idle_timeout, expired connections are also dropped lazily by lease
+  void evict_idle()
+  {
+    const auto now = clock::now();
+
+    for(auto& s : m_shards_)
+    {
+      std::vector<socket_type> expired;
+
+      {
+        std::lock_guard lock(s.mutex);
+
+        for(auto it = s.idle.begin(); it != s.idle.end();)
+        {
+          auto& conns = it->second;
+
+          //oldest connections are in front
+          std::size_t n = 0;
+          while(n != conns.size() && is_expired(conns[n], now)) ++n;
+
+          for(std::size_t i = 0; i != n; ++i) expired.push_back(std::move(conns[i].sock));
+          conns.erase(conns.begin(), conns.begin() + n);
+
+          it = conns.empty() ? s.idle.erase(it) : std::next(it);
+        }
+      }
+
+      m_idle_count_.fetch_sub(expired.size(), std::memory_order_relaxed);
+    }
+  }
+
+  std::size_t idle_count() const noexcept { return m_idle_count_.load(std::memory_order_relaxed); }
+
+private:
+  using clock = std::chrono::steady_clock;
+
+  struct idle_connection
+  {
+    socket_type sock;
+    clock::time_point since;
+  };
+
+  struct alignas(details::cache_line_size) shard
+  {
+    std::mutex mutex;
+    std::unordered_map<address_type, std::vector<idle_connection>> idle;
+  };
+
+  bool is_expired(const idle_connection& c, clock::time_point now) const noexcept
+  {
+    return now - c.since >= m_settings_.idle_timeout;
+  }
+
+  shard& shard_of(const address_type& addr) noexcept
+  {
+    return m_shards_[std::hash<address_type>{}(addr) % Shards];
+  }
+
+  static bool is_healthy(const socket_type& sock) noexcept
+  {
+    pollfd fd{ .fd = details::socket_access::handle(sock), .events = std::to_underlying(PollFlags::In), .revents = 0 };
+
+    return HPP_IFE(HPP_WIN_IMPL)(::WSAPoll)(::poll)(&fd, 1, 0) == 0;
+  }
+
+  std::optional<socket_type> take_idle(const address_type& addr)
+  {
+    auto& s = shard_of(addr);
+    const auto now = clock::now();
+
+    for(;;)
+    {
+      std::optional<idle_connection> c;
+
+      {
+        std::lock_guard lock(s.mutex);
+
+        auto it = s.idle.find(addr);
+        if(it == s.idle.end()) return std::nullopt;
+
+        c.emplace(std::move(it->second.back()));
+        it->second.pop_back();
+        if(it->second.empty()) s.idle.erase(it);
+      }
+
+      m_idle_count_.fetch_sub(1, std::memory_order_relaxed);
+
+      //poll and close of rejected connection are done outside of lock
+      if(!is_expired(*c, now) && is_healthy(c->sock)) return std::move(c->sock);
+    }
+  }
+
+  void give_back(const address_type& addr, socket_type&& sock) noexcept
+  {
+    if(m_settings_.max_idle_per_address == 0) return;
+
+    if(m_idle_count_.fetch_add(1, std::memory_order_relaxed) >= m_settings_.max_idle)
+    {
+      m_idle_count_.fetch_sub(1, std::memory_order_relaxed);
+      return;
+    }
+
+    auto& s = shard_of(addr);
+
+    try
+    {
+      std::lock_guard lock(s.mutex);
+
+      auto& conns = s.idle[addr];
+      if(conns.size() < m_settings_.max_idle_per_address)
+      {
+        conns.push_back({std::move(sock), clock::now()});
+        return;
+      }
+    }
+    catch(...)
+    {
+      //allocation failure only means connection is not pooled
+    }
+
+    m_idle_count_.fetch_sub(1, std::memory_order_relaxed);
+  }
+
+  PoolSettings m_settings_;
+  std::array<shard, Shards> m_shards_;
+  alignas(details::cache_line_size) std::atomic<std::size_t> m_idle_count_ = 0;
+};
+
+} //namespace cpps
@@ -2,9 +2,36 @@
 
 #include "socket.hpp"
 
+#include <chrono>
+#include <optional>
+#include <vector>
+#include "details/configure.hpp"
+#include "details/parallel_connect.hpp"
+
 namespace cpps
 {
 
+//deadlines of Net::connect_first/connect_all
+struct ConnectOptions
+{
+  //single connect attempt is abandoned after this time
+  std::chrono::milliseconds attempt_timeout = std::chrono::seconds(3);
+
+  //no attempt is started or waited for after this time
+  std::chrono::milliseconds total_timeout = std::chrono::seconds(10);
+
+  //connect_first starts next candidate after this time while previous ones are in progress
+  std::chrono::milliseconds attempt_delay = std::chrono::milliseconds(250);
+};
+
+//outcome of one address of Net::connect_all, error is set when sock is empty
+template<SocketInfo SI, ConnectionSettings SCS = default_connection_settings>
+struct ConnectResult
+{
+  std::optional<Socket<SI, inv_connect, SCS>> sock;
+  std::optional<sys_errc::ErrorCode> error;
+};
+
 struct Net
 {
   template<auto EHP = ehl::Policy::Exception>
@@ -41,6 +68,10 @@ struct Net
 
     EHL_THROW_IF(sfd.is_invalid(), sys_errc::last_error());
 
+    int r = details::configure<SI>(sfd);
+
+    EHL_THROW_IF(r != 0, sys_errc::last_error());
+
     return Socket<SI, inv_none, default_connection_settings>(std::move(sfd));
   }
 
@@ -52,11 +83,24 @@ struct Net
 
     EHL_THROW_IF(sfd.is_invalid(), sys_errc::last_error());
 
-    int r = ::connect(sfd, details::to_sockaddr_ptr(&dest_addr), sizeof(dest_addr));
+    int r = details::configure<SI>(sfd);
 
     EHL_THROW_IF(r != 0, sys_errc::last_error());
 
-    return Socket<SI, inv_connect, SCS>(std::move(sfd));
+    r = ::connect(sfd, details::to_sockaddr_ptr(&dest_addr), details::sockaddr_length(dest_addr));
+
+    EHL_THROW_IF(r != 0, sys_errc::last_error());
+
+    Socket<SI, inv_connect, SCS> sock(std::move(sfd));
+
+    if constexpr(SCS.negotiate_byte_order)
+    {
+      const auto err = sock.exchange_hello();
+
+      EHL_THROW_IF(err.has_value(), *err);
+    }
+
+    return sock;
   }
 
   template<SocketInfo SI, ConnectionSettings SCS = default_connection_settings, auto EHP = ehl::Policy::Exception>
@@ -68,17 +112,28 @@ struct Net
 
     EHL_THROW_IF(sfd.is_invalid(), sys_errc::last_error());
 
-    int r;
+    int r = details::configure<SI>(sfd);
+
+    EHL_THROW_IF(r != 0, sys_errc::last_error());
 
-    r = ::bind(sfd, details::to_sockaddr_ptr(&bind_addr), sizeof(bind_addr));
+    r = ::bind(sfd, details::to_sockaddr_ptr(&bind_addr), details::sockaddr_length(bind_addr));
 
     EHL_THROW_IF(r != 0, sys_errc::last_error());
 
-    r = ::connect(sfd, details::to_sockaddr_ptr(&dest_addr), sizeof(dest_addr));
+    r = ::connect(sfd, details::to_sockaddr_ptr(&dest_addr), details::sockaddr_length(dest_addr));
 
     EHL_THROW_IF(r != 0, sys_errc::last_error());
 
-    return Socket<SI, inv_bind_connect, SCS>(std::move(sfd));
+    Socket<SI, inv_bind_connect, SCS> sock(std::move(sfd));
+
+    if constexpr(SCS.negotiate_byte_order)
+    {
+      const auto err = sock.exchange_hello();
+
+      EHL_THROW_IF(err.has_value(), *err);
+    }
+
+    return sock;
   }
 
   template<SocketInfo SI, auto EHP = ehl::Policy::Exception>
@@ -90,14 +145,47 @@ struct Net
 
     EHL_THROW_IF(sfd.is_invalid(), sys_errc::last_error());
 
-    int r = ::bind(sfd, details::to_sockaddr_ptr(&bind_addr), sizeof(bind_addr));
+    int r = details::configure<SI>(sfd);
+
+    EHL_THROW_IF(r != 0, sys_errc::last_error());
+
+    r = ::bind(sfd, details::to_sockaddr_ptr(&bind_addr), details::sockaddr_length(bind_addr));
 
     EHL_THROW_IF(r != 0, sys_errc::last_error());
 
     return Socket<SI, inv_bind, default_connection_settings>(std::move(sfd));
   }
 
-  template<SocketInfo SI, auto EHP = ehl::Policy::Exception> requires (SI.type == SocketType::Stream)
+  //Datagram socket for receiving multicast, bound with SO_REUSEADDR so several receivers
+  //on same host can listen on port of group; groups are joined with cpps::join_group (multicast.hpp).
+  //bind_addr is usually wildcard address, binding to group address filters out other groups on Linux
+  template<SocketInfo SI, auto EHP = ehl::Policy::Exception>
+    requires (SI.type == SocketType::Datagram && SI.address_family != AddressFamily::Unix)
+  [[nodiscard]] ehl::Result_t<Socket<SI, inv_bind, default_connection_settings>, sys_errc::ErrorCode, EHP>
+  multicast_socket(const Address<SI.address_family>& bind_addr)
+    const noexcept(EHP != ehl::Policy::Exception)
+  {
+    details::socket_resource sfd = ::socket((int)SI.address_family, (int)SI.type, (int)SI.protocol);
+
+    EHL_THROW_IF(sfd.is_invalid(), sys_errc::last_error());
+
+    int r = details::configure<SI>(sfd);
+
+    EHL_THROW_IF(r != 0, sys_errc::last_error());
+
+    int reuse = 1;
+    r = ::setsockopt(sfd, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&reuse), sizeof(reuse));
+
+    EHL_THROW_IF(r != 0, sys_errc::last_error());
+
+    r = ::bind(sfd, details::to_sockaddr_ptr(&bind_addr), details::sockaddr_length(bind_addr));
+
+    EHL_THROW_IF(r != 0, sys_errc::last_error());
+
+    return Socket<SI, inv_bind, default_connection_settings>(std::move(sfd));
+  }
+
+  template<SocketInfo SI, auto EHP = ehl::Policy::Exception> requires (SI.type != SocketType::Datagram)
   [[nodiscard]] ehl::Result_t<Socket<SI, inv_bind_listen, default_connection_settings>, sys_errc::ErrorCode, EHP>
   server_socket(const Address<SI.address_family>& bind_addr, unsigned max_connections)
     const noexcept(EHP != ehl::Policy::Exception)
@@ -106,9 +194,47 @@ struct Net
 
     EHL_THROW_IF(sfd.is_invalid(), sys_errc::last_error());
 
-    int r;
+    int r = details::configure<SI>(sfd);
+
+    EHL_THROW_IF(r != 0, sys_errc::last_error());
+
+    r = ::bind(sfd, details::to_sockaddr_ptr(&bind_addr), details::sockaddr_length(bind_addr));
+
+    EHL_THROW_IF(r != 0, sys_errc::last_error());
+
+    r = ::listen(sfd, max_connections);
+
+    EHL_THROW_IF(r != 0, sys_errc::last_error());
+
+    return Socket<SI, inv_bind_listen, default_connection_settings>(std::move(sfd));
+  }
+
+  //Listening socket accepting TCP Fast Open, fast_open_queue limits pending connections with data in SYN
+  //(on Windows queue length is not configurable and only enables option)
+  template<SocketInfo SI, auto EHP = ehl::Policy::Exception> requires (SI.protocol == SocketProtocol::TCP)
+  [[nodiscard]] ehl::Result_t<Socket<SI, inv_bind_listen, default_connection_settings>, sys_errc::ErrorCode, EHP>
+  server_socket(const Address<SI.address_family>& bind_addr, unsigned max_connections, unsigned fast_open_queue)
+    const noexcept(EHP != ehl::Policy::Exception)
+  {
+    details::socket_resource sfd = ::socket((int)SI.address_family, (int)SI.type, (int)SI.protocol);
+
+    EHL_THROW_IF(sfd.is_invalid(), sys_errc::last_error());
+
+    int r = details::configure<SI>(sfd);
+
+    EHL_THROW_IF(r != 0, sys_errc::last_error());
+
+    r = ::bind(sfd, details::to_sockaddr_ptr(&bind_addr), details::sockaddr_length(bind_addr));
+
+    EHL_THROW_IF(r != 0, sys_errc::last_error());
 
-    r = ::bind(sfd, details::to_sockaddr_ptr(&bind_addr), sizeof(bind_addr));
+#if HPP_WIN_IMPL
+    DWORD fast_open = fast_open_queue != 0;
+#else
+    int fast_open = static_cast<int>(fast_open_queue);
+#endif
+
+    r = ::setsockopt(sfd, IPPROTO_TCP, TCP_FASTOPEN, reinterpret_cast<const char*>(&fast_open), sizeof(fast_open));
 
     EHL_THROW_IF(r != 0, sys_errc::last_error());
 
@@ -119,8 +245,295 @@ struct Net
     return Socket<SI, inv_bind_listen, default_connection_settings>(std::move(sfd));
   }
 
+  //Connects and sends first packet. With TCP Fast Open (Linux MSG_FASTOPEN) packet goes in SYN
+  //when server cookie is cached, saving one round trip, otherwise kernel does regular handshake requesting cookie.
+  //When client side of fast open is disabled (net.ipv4.tcp_fastopen) sendto fails with EOPNOTSUPP
+  //and it is connect followed by send, as on other platforms
+  template<
+    SocketInfo SI,
+    ConnectionSettings SCS = default_connection_settings,
+    auto EHP = ehl::Policy::Exception,
+    packet_type T> requires (SI.protocol == SocketProtocol::TCP)
+  [[nodiscard]] ehl::Result_t<Socket<SI, inv_connect, SCS>, sys_errc::ErrorCode, EHP>
+  client_socket(const Address<SI.address_family>& dest_addr, const valid_packet<T>& first_packet)
+    const noexcept(EHP != ehl::Policy::Exception)
+  {
+    static_assert(!SCS.negotiate_byte_order, "first packet is sent before byte order could be negotiated");
+    static_assert(SCS.encoding == WireEncoding::Raw && !SCS.delta_encoding, "first packet is sent raw encoded");
+
+    details::socket_resource sfd = ::socket((int)SI.address_family, (int)SI.type, (int)SI.protocol);
+
+    EHL_THROW_IF(sfd.is_invalid(), sys_errc::last_error());
+
+    int r = details::configure<SI>(sfd);
+
+    EHL_THROW_IF(r != 0, sys_errc::last_error());
+
+    T t = first_packet;
+    if constexpr(SCS.convert_byte_order)
+      details::convert_byte_order(t);
+
+#if defined(MSG_FASTOPEN)
+    auto sent = ::sendto(
+      sfd, reinterpret_cast<const char*>(&t), sizeof(T), MSG_FASTOPEN,
+      details::to_sockaddr_ptr(&dest_addr), details::sockaddr_length(dest_addr));
+
+    const bool fast_open = sent >= 0 || errno != EOPNOTSUPP;
+#else
+    decltype(::send(sfd, nullptr, 0, 0)) sent = -1;
+
+    const bool fast_open = false;
+#endif
+
+    if(!fast_open)
+    {
+      r = ::connect(sfd, details::to_sockaddr_ptr(&dest_addr), details::sockaddr_length(dest_addr));
+
+      EHL_THROW_IF(r != 0, sys_errc::last_error());
+
+      sent = ::send(sfd, reinterpret_cast<const char*>(&t), sizeof(T), 0);
+    }
+
+    //return system error or wrong_protocol_type to indicate interruption of send
+    EHL_THROW_IF(
+      sent != sizeof(T),
+      sent < 0 ? sys_errc::last_error() : sys_errc::ErrorCode(sys_errc::common::sockets::wrong_protocol_type));
+
+    return Socket<SI, inv_connect, SCS>(std::move(sfd));
+  }
+
+  template<
+    SocketInfo SI,
+    ConnectionSettings SCS = default_connection_settings,
+    auto EHP = ehl::Policy::Exception,
+    packet_type T> requires (SI.protocol == SocketProtocol::TCP)
+  [[nodiscard]] ehl::Result_t<Socket<SI, inv_connect, SCS>, sys_errc::ErrorCode, EHP>
+  client_socket(const Address<SI.address_family>& dest_addr, const T& first_packet)
+    const noexcept(EHP != ehl::Policy::Exception)
+  {
+    EHL_THROW_IF(!first_packet.is_valid(), sys_errc::ErrorCode(sys_errc::common::sockets::invalid_argument));
+
+    return client_socket<SI, SCS, EHP, T>(dest_addr, std::bit_cast<valid_packet<T>>(first_packet));
+  }
+
+  //Connects to first reachable candidate: attempts are started one by one every attempt_delay,
+  //or right away when previous attempt fails, and raced with non-blocking connect.
+  //For dual-stack sockets native IPv6 and IPv4-mapped candidates are interleaved (happy eyeballs, RFC 8305).
+  //Error of last failed attempt is reported when all attempts fail, invalid_argument when there are no candidates
+  template<SocketInfo SI, ConnectionSettings SCS = default_connection_settings, auto EHP = ehl::Policy::Exception>
+    requires (SI.type != SocketType::Datagram)
+  [[nodiscard]] ehl::Result_t<Socket<SI, inv_connect, SCS>, sys_errc::ErrorCode, EHP>
+  connect_first(std::span<const Address<SI.address_family>> candidates, const ConnectOptions& options = {})
+    const noexcept(EHP != ehl::Policy::Exception)
+  {
+    EHL_THROW_IF(candidates.empty(), sys_errc::ErrorCode(sys_errc::common::sockets::invalid_argument));
+
+    const auto order = details::interleave_families(candidates);
+
+    std::optional<details::socket_resource> winner;
+    int last_error = details::timed_out_code;
+
+    run_connects<SI>(order, options, options.attempt_delay, [&](std::size_t, details::socket_resource&& sfd, int err)
+    {
+      if(err != 0)
+      {
+        last_error = err;
+        return false;
+      }
+
+      winner.emplace(std::move(sfd));
+      return true;
+    });
+
+    EHL_THROW_IF(!winner, sys_errc::ErrorCode(last_error));
+
+    Socket<SI, inv_connect, SCS> sock(std::move(*winner));
+
+    if constexpr(SCS.negotiate_byte_order)
+    {
+      const auto err = sock.exchange_hello();
+
+      EHL_THROW_IF(err.has_value(), *err);
+    }
+
+    return sock;
+  }
+
+  //Connects to all addresses in parallel, results are in order of addresses
+  template<SocketInfo SI, ConnectionSettings SCS = default_connection_settings>
+    requires (SI.type != SocketType::Datagram)
+  [[nodiscard]] std::vector<ConnectResult<SI, SCS>>
+  connect_all(std::span<const Address<SI.address_family>> addrs, const ConnectOptions& options = {}) const
+  {
+    std::vector<ConnectResult<SI, SCS>> res(addrs.size());
+
+    run_connects<SI>(addrs, options, std::chrono::milliseconds(0), [&](std::size_t i, details::socket_resource&& sfd, int err)
+    {
+      if(err != 0)
+        res[i].error.emplace(sys_errc::ErrorCode(err));
+      else
+        res[i].sock.emplace(Socket<SI, inv_connect, SCS>(std::move(sfd)));
+
+      return false;
+    });
+
+    //peers answer hello on their own, so handshakes are done after all connects
+    if constexpr(SCS.negotiate_byte_order)
+    {
+      for(auto& c : res)
+      {
+        if(!c.sock) continue;
+
+        c.error = c.sock->exchange_hello();
+        if(c.error) c.sock.reset();
+      }
+    }
+
+    return res;
+  }
+
+#if HPP_POSIX_IMPL
+  //pair of connected unix domain sockets, e.g. for communication with forked process
+  template<SocketInfo SI, ConnectionSettings SCS = default_connection_settings, auto EHP = ehl::Policy::Exception>
+    requires (SI.address_family == AddressFamily::Unix)
+  [[nodiscard]] ehl::Result_t<std::pair<Socket<SI, inv_connect, SCS>, Socket<SI, inv_connect, SCS>>, sys_errc::ErrorCode, EHP>
+  socket_pair() const noexcept(EHP != ehl::Policy::Exception)
+  {
+    details::socket_resource::Handle fds[2];
+
+    int r = ::socketpair((int)SI.address_family, (int)SI.type, (int)SI.protocol, fds);
+
+    EHL_THROW_IF(r != 0, sys_errc::last_error());
+
+    std::pair socks{Socket<SI, inv_connect, SCS>(fds[0]), Socket<SI, inv_connect, SCS>(fds[1])};
+
+    //both ends are on same host
+    if constexpr(SCS.negotiate_byte_order)
+      socks.first.m_byte_order_.native = socks.second.m_byte_order_.native = true;
+
+    return socks;
+  }
+#endif
+
 private:
   constexpr Net() noexcept = default;
+
+  //Starts connect to addrs[i] every delay (or when nothing is pending) and waits for them with poll.
+  //on_done(index, socket, error) is called once per started address, socket is valid only when error is 0,
+  //returning true stops everything; addresses not started in time are reported as timed out
+  template<SocketInfo SI, typename F>
+  static void run_connects(
+    std::span<const Address<SI.address_family>> addrs,
+    const ConnectOptions& options,
+    std::chrono::milliseconds delay,
+    F&& on_done)
+  {
+    using clock = std::chrono::steady_clock;
+
+    struct attempt
+    {
+      details::socket_resource sfd;
+      std::size_t index;
+      clock::time_point deadline;
+    };
+
+    const auto total_deadline = clock::now() + options.total_timeout;
+
+    std::vector<attempt> pending;
+    std::vector<pollfd> fds;
+    std::size_t next = 0;
+    auto next_start = clock::now();
+
+    for(;;)
+    {
+      auto now = clock::now();
+
+      while(next != addrs.size() && now < total_deadline && (now >= next_start || pending.empty()))
+      {
+        const std::size_t i = next++;
+        details::socket_resource sfd = ::socket((int)SI.address_family, (int)SI.type, (int)SI.protocol);
+
+        int err =
+          sfd.is_invalid() || details::configure<SI>(sfd) != 0 ?
+            details::last_error_code() : details::start_connect(sfd, addrs[i]);
+
+        if(err == details::connect_in_progress)
+        {
+          pending.push_back({std::move(sfd), i, std::min(now + options.attempt_timeout, total_deadline)});
+          next_start = now + delay;
+          continue;
+        }
+
+        if(err == 0) err = details::finish_connect(sfd);
+
+        if(on_done(i, std::move(sfd), err)) return;
+      }
+
+      for(auto it = pending.begin(); it != pending.end();)
+      {
+        if(it->deadline > now)
+        {
+          ++it;
+          continue;
+        }
+
+        const std::size_t i = it->index;
+        it = pending.erase(it);
+        next_start = now;
+
+        if(on_done(i, details::socket_resource(details::socket_resource::INVALID_HANDLE), details::timed_out_code)) return;
+      }
+
+      if(pending.empty() && (next == addrs.size() || now >= total_deadline)) break;
+
+      if(pending.empty()) continue;
+
+      auto wake = total_deadline;
+      for(const auto& a : pending) wake = std::min(wake, a.deadline);
+      if(next != addrs.size()) wake = std::min(wake, next_start);
+
+      const auto timeout = std::chrono::ceil<std::chrono::milliseconds>(wake - now).count();
+
+      fds.clear();
+      for(const auto& a : pending) fds.push_back({ .fd = a.sfd, .events = POLLOUT, .revents = 0 });
+
+      const int r = HPP_IFE(HPP_WIN_IMPL)(::WSAPoll)(::poll)(fds.data(), static_cast<unsigned>(fds.size()), static_cast<int>(std::max<decltype(timeout)>(timeout, 0)));
+
+      if(r < 0)
+      {
+        const int err = details::last_error_code();
+        if(err == HPP_IFE(HPP_WIN_IMPL)(WSAEINTR)(EINTR)) continue;
+
+        for(auto& a : pending)
+          if(on_done(a.index, std::move(a.sfd), err)) return;
+
+        pending.clear();
+        break;
+      }
+
+      //failed attempt lets next candidate start right away
+      std::size_t kept = 0;
+      for(std::size_t k = 0; k != pending.size(); ++k)
+      {
+        if(fds[k].revents == 0)
+        {
+          if(kept != k) pending[kept] = std::move(pending[k]);
+          ++kept;
+          continue;
+        }
+
+        const int err = details::finish_connect(pending[k].sfd);
+        if(err != 0) next_start = now;
+
+        if(on_done(pending[k].index, std::move(pending[k].sfd), err)) return;
+      }
+
+      pending.erase(pending.begin() + kept, pending.end());
+    }
+
+    for(; next != addrs.size(); ++next)
+      if(on_done(next, details::socket_resource(details::socket_resource::INVALID_HANDLE), details::timed_out_code)) return;
+  }
 };
 
 } //namespace cpps
@@ -0,0 +1,205 @@
+#pragma once
+
+#include "platform_headers.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include "socket_resource.hpp"
+#include "cppsocket/address.hpp"
+
+#if HPP_POSIX_IMPL
+  #include <sys/uio.h>
+#endif
+
+namespace cpps::details
+{
+
+//upper bound of messages or buffers passed to kernel in one call
+constexpr unsigned max_batch_size = 64;
+
+struct const_buffer
+{
+  const void* data;
+  std::size_t size;
+};
+
+struct outgoing_datagram
+{
+  const_buffer buffer;
+  const sockaddr* addr;
+  socklen_type addrlen;
+};
+
+struct incoming_datagram
+{
+  void* data;
+  std::size_t size;
+  sockaddr* addr;
+  //capacity of addr on input, length of sender address on output
+  socklen_type addrlen;
+  std::size_t received;
+};
+
+//sends up to max_batch_size datagrams with single syscall where supported (sendmmsg),
+//returns number of sent datagrams or -1 if first datagram failed
+inline int send_datagrams(socket_resource::Handle h, const outgoing_datagram* dgrams, unsigned count) noexcept
+{
+  count = (std::min)(count, max_batch_size);
+
+#if defined(__linux__)
+  mmsghdr msgs[max_batch_size];
+  iovec iovs[max_batch_size];
+
+  for(unsigned i = 0; i != count; ++i)
+  {
+    iovs[i] = { const_cast<void*>(dgrams[i].buffer.data), dgrams[i].buffer.size };
+
+    msgs[i] = {};
+    msgs[i].msg_hdr.msg_name    = const_cast<sockaddr*>(dgrams[i].addr);
+    msgs[i].msg_hdr.msg_namelen = dgrams[i].addrlen;
+    msgs[i].msg_hdr.msg_iov     = &iovs[i];
+    msgs[i].msg_hdr.msg_iovlen  = 1;
+  }
+
+  return ::sendmmsg(h, msgs, count, 0);
+#else
+  for(unsigned i = 0; i != count; ++i)
+  {
+    auto r = ::sendto(
+      h, static_cast<const char*>(dgrams[i].buffer.data), dgrams[i].buffer.size, 0, dgrams[i].addr, dgrams[i].addrlen);
+
+    if(r < 0) return i == 0 ? -1 : static_cast<int>(i);
+  }
+
+  return static_cast<int>(count);
+#endif
+}
+
+//receives up to max_batch_size datagrams with single syscall where supported (recvmmsg),
+//waits only for first datagram, returns number of received datagrams or -1 on error
+inline int recv_datagrams(socket_resource::Handle h, incoming_datagram* dgrams, unsigned count) noexcept
+{
+  count = (std::min)(count, max_batch_size);
+
+#if defined(__linux__)
+  mmsghdr msgs[max_batch_size];
+  iovec iovs[max_batch_size];
+
+  for(unsigned i = 0; i != count; ++i)
+  {
+    iovs[i] = { dgrams[i].data, dgrams[i].size };
+
+    msgs[i] = {};
+    msgs[i].msg_hdr.msg_name    = dgrams[i].addr;
+    msgs[i].msg_hdr.msg_namelen = dgrams[i].addrlen;
+    msgs[i].msg_hdr.msg_iov     = &iovs[i];
+    msgs[i].msg_hdr.msg_iovlen  = 1;
+  }
+
+  int r = ::recvmmsg(h, msgs, count, MSG_WAITFORONE, nullptr);
+
+  for(int i = 0; i < r; ++i)
+  {
+    dgrams[i].addrlen  = msgs[i].msg_hdr.msg_namelen;
+    dgrams[i].received = msgs[i].msg_len;
+  }
+
+  return r;
+#else
+  (void)count;
+
+  auto r = ::recvfrom(h, static_cast<char*>(dgrams[0].data), dgrams[0].size, 0, dgrams[0].addr, &dgrams[0].addrlen);
+
+  if(r < 0) return -1;
+
+  dgrams[0].received = static_cast<std::size_t>(r);
+
+  return 1;
+#endif
+}
+
+//sends all bytes of up to max_batch_size buffers as one gathered write (sendmsg/WSASend),
+//continues after partial writes, returns false on error
+inline bool send_all(socket_resource::Handle h, const const_buffer* bufs, unsigned count) noexcept
+{
+  count = (std::min)(count, max_batch_size);
+
+#if HPP_WIN_IMPL
+  WSABUF wbufs[max_batch_size];
+
+  for(unsigned i = 0; i != count; ++i)
+    wbufs[i] = { static_cast<ULONG>(bufs[i].size), static_cast<CHAR*>(const_cast<void*>(bufs[i].data)) };
+
+  DWORD sent = 0;
+
+  //blocking WSASend completes only when all buffers are sent
+  return ::WSASend(h, wbufs, count, &sent, 0, nullptr, nullptr) == 0;
+#elif HPP_POSIX_IMPL
+  iovec iovs[max_batch_size];
+
+  for(unsigned i = 0; i != count; ++i)
+    iovs[i] = { const_cast<void*>(bufs[i].data), bufs[i].size };
+
+  msghdr msg{};
+  msg.msg_iov    = iovs;
+  msg.msg_iovlen = count;
+
+  while(msg.msg_iovlen != 0)
+  {
+    auto r = ::sendmsg(h, &msg, 0);
+
+    if(r < 0) return false;
+
+    //skip fully sent buffers and adjust partially sent one
+    auto n = static_cast<std::size_t>(r);
+    while(msg.msg_iovlen != 0 && n >= msg.msg_iov->iov_len)
+    {
+      n -= msg.msg_iov->iov_len;
+      ++msg.msg_iov;
+      --msg.msg_iovlen;
+    }
+
+    if(msg.msg_iovlen != 0)
+    {
+      msg.msg_iov->iov_base = static_cast<char*>(msg.msg_iov->iov_base) + n;
+      msg.msg_iov->iov_len -= n;
+    }
+  }
+
+  return true;
+#endif
+}
+
+//sends up to max_batch_size buffers as one datagram, to addr or to connected peer when addr is null,
+//returns false on error
+inline bool send_gathered_datagram(
+  socket_resource::Handle h, const const_buffer* bufs, unsigned count, const sockaddr* addr, socklen_type addrlen) noexcept
+{
+  count = (std::min)(count, max_batch_size);
+
+#if HPP_WIN_IMPL
+  WSABUF wbufs[max_batch_size];
+
+  for(unsigned i = 0; i != count; ++i)
+    wbufs[i] = { static_cast<ULONG>(bufs[i].size), static_cast<CHAR*>(const_cast<void*>(bufs[i].data)) };
+
+  DWORD sent = 0;
+
+  return ::WSASendTo(h, wbufs, count, &sent, 0, addr, addr ? addrlen : 0, nullptr, nullptr) == 0;
+#elif HPP_POSIX_IMPL
+  iovec iovs[max_batch_size];
+
+  for(unsigned i = 0; i != count; ++i)
+    iovs[i] = { const_cast<void*>(bufs[i].data), bufs[i].size };
+
+  msghdr msg{};
+  msg.msg_name    = const_cast<sockaddr*>(addr);
+  msg.msg_namelen = addr ? addrlen : 0;
+  msg.msg_iov     = iovs;
+  msg.msg_iovlen  = count;
+
+  return ::sendmsg(h, &msg, 0) >= 0;
+#endif
+}
+
+} //namespace cpps::details
@@ -0,0 +1,172 @@
+#pragma once
+
+#include "platform_headers.hpp"
+
+#include <bit>
+#include <chrono>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <system_errc/system_errc.hpp>
+#include <aggr_refl/aggregate_reflection.hpp>
+#include "cppsocket/fixed_t.hpp"
+#include "apply_index.hpp"
+#include "batch_io.hpp"
+#include "socket_resource.hpp"
+
+namespace cpps::details
+{
+
+constexpr std::uint64_t fnv_offset_basis = 14695981039346656037ull;
+
+//FNV-1a step over 8 bytes of v
+constexpr std::uint64_t fnv_step(std::uint64_t h, std::uint64_t v) noexcept
+{
+  for(unsigned i = 0; i != 8; ++i)
+  {
+    h ^= (v >> (8 * i)) & 0xFF;
+    h *= 1099511628211ull;
+  }
+
+  return h;
+}
+
+//Hash of kind and size of every scalar field in declaration order
+template<typename T>
+struct layout_hash;
+
+template<typename T>
+struct layout_hash<fixed_t<T>>
+{
+  static constexpr std::uint64_t apply(std::uint64_t h) noexcept
+  {
+    const std::uint64_t kind = std::signed_integral<T> ? 1 : (std::integral<T> ? 2 : 3);
+
+    return fnv_step(h, kind << 32 | sizeof(T));
+  }
+};
+
+template<typename T, std::size_t N>
+struct layout_hash<T[N]>
+{
+  static constexpr std::uint64_t apply(std::uint64_t h) noexcept
+  {
+    h = fnv_step(h, std::uint64_t(4) << 32 | N);
+    for(std::size_t i = 0; i != N; ++i) h = layout_hash<T>::apply(h);
+
+    return h;
+  }
+};
+
+template<typename T>
+  requires std::is_class_v<T>
+struct layout_hash<T>
+{
+  static constexpr std::uint64_t apply(std::uint64_t h) noexcept
+  {
+    h = fnv_step(h, std::uint64_t(5) << 32 | sizeof(T));
+
+    return apply_index<aggr_refl::tuple_size_v<T>>([h](auto... Is) mutable
+    {
+      ((h = layout_hash<aggr_refl::tuple_element_t<Is, T>>::apply(h)), ...);
+      return h;
+    });
+  }
+};
+
+template<typename... Ts>
+constexpr std::uint64_t layout_fingerprint() noexcept
+{
+  std::uint64_t h = fnv_step(fnv_offset_basis, sizeof...(Ts));
+  ((h = layout_hash<Ts>::apply(h)), ...);
+
+  return h;
+}
+
+//First bytes sent by both ends of connection negotiating byte order
+struct byte_order_hello
+{
+  std::byte magic[4];
+  std::byte order;
+  std::byte reserved[3];
+  //big endian
+  std::byte fingerprint[8];
+};
+
+constexpr std::byte hello_magic[4] = {std::byte{'C'}, std::byte{'P'}, std::byte{'S'}, std::byte{'B'}};
+
+constexpr byte_order_hello make_hello(std::uint64_t fingerprint) noexcept
+{
+  byte_order_hello hello{};
+
+  for(unsigned i = 0; i != 4; ++i) hello.magic[i] = hello_magic[i];
+  hello.order = std::byte{std::endian::native == std::endian::little ? 1 : 2};
+  for(unsigned i = 0; i != 8; ++i) hello.fingerprint[i] = static_cast<std::byte>(fingerprint >> (8 * (7 - i)));
+
+  return hello;
+}
+
+//Sends own hello and receives peer one, native is set when peer has same byte order and packet layouts.
+//Peer hello must arrive within timeout_ms, 0 waits without limit.
+//Returns error: system one, not_connected when peer closed connection, timed_out when peer hello
+//did not arrive in time or wrong_protocol_type for malformed hello
+inline std::optional<sys_errc::ErrorCode> exchange_hello(
+  socket_resource::Handle h, std::uint64_t fingerprint, unsigned timeout_ms, bool& native) noexcept
+{
+  const byte_order_hello mine = make_hello(fingerprint);
+  const const_buffer buf{&mine, sizeof(mine)};
+
+  //both ends send first, hello always fits into socket buffer
+  if(!send_all(h, &buf, 1)) return sys_errc::last_error();
+
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+
+  byte_order_hello peer;
+  std::size_t size = 0;
+
+  //peer may send hello in parts, so deadline bounds whole hello rather than each receive
+  while(size != sizeof(peer))
+  {
+    if(timeout_ms != 0)
+    {
+      const auto left = std::chrono::ceil<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+
+      pollfd fd{ .fd = h, .events = POLLIN, .revents = 0 };
+      auto p = HPP_IFE(HPP_WIN_IMPL)(::WSAPoll)(::poll)(&fd, 1, left.count() > 0 ? static_cast<int>(left.count()) : 0);
+
+      if(p < 0) return sys_errc::last_error();
+      if(p == 0) return sys_errc::ErrorCode(sys_errc::common::sockets::timed_out);
+    }
+
+    const std::size_t missing = sizeof(peer) - size;
+
+    auto r = ::recv(
+      h, reinterpret_cast<char*>(&peer) + size, HPP_IFE(HPP_WIN_IMPL)(static_cast<int>(missing))(missing),
+      timeout_ms != 0 ? 0 : MSG_WAITALL);
+
+    if(r < 0) return sys_errc::last_error();
+    if(r == 0) return sys_errc::ErrorCode(sys_errc::common::sockets::not_connected);
+
+    size += static_cast<std::size_t>(r);
+  }
+
+  if(std::bit_cast<std::uint32_t>(peer.magic) != std::bit_cast<std::uint32_t>(mine.magic))
+    return sys_errc::ErrorCode(sys_errc::common::sockets::wrong_protocol_type);
+
+  native =
+    peer.order == mine.order &&
+    std::bit_cast<std::uint64_t>(peer.fingerprint) == std::bit_cast<std::uint64_t>(mine.fingerprint);
+
+  return std::nullopt;
+}
+
+//byte order state of connection negotiating it, native is false until handshake
+struct negotiated_byte_order
+{
+  bool native = false;
+};
+
+struct fixed_byte_order {};
+
+} //namespace cpps::details
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "platform_headers.hpp"
+
+#include "socket_resource.hpp"
+#include "../socket.hpp"
+
+namespace cpps::details
+{
+
+//socket options implied by SocketInfo, applied before bind/connect,
+//returns 0 on success, otherwise error is available through sys_errc::last_error()
+template<SocketInfo SI>
+int configure([[maybe_unused]] const socket_resource& sfd) noexcept
+{
+  if constexpr(SI.dual_stack)
+  {
+    int v6only = 0;
+    return ::setsockopt(sfd, IPPROTO_IPV6, IPV6_V6ONLY, reinterpret_cast<const char*>(&v6only), sizeof(v6only));
+  }
+  else
+    return 0;
+}
+
+} //namespace cpps::details
@@ -0,0 +1,24 @@
+#pragma once
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+  #include <immintrin.h>
+#elif defined(_M_ARM64) || defined(_M_ARM)
+  #include <intrin.h>
+#endif
+
+namespace cpps::details
+{
+
+//spin-wait hint, lets sibling hyperthread run and saves power while spinning
+inline void cpu_relax() noexcept
+{
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+  _mm_pause();
+#elif defined(_M_ARM64) || defined(_M_ARM)
+  __yield();
+#elif defined(__aarch64__) || defined(__arm__)
+  __asm__ __volatile__("yield");
+#endif
+}
+
+} //namespace cpps::details
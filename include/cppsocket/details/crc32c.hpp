@@ -0,0 +1,134 @@
+#pragma once
+
+#if defined(__SSE4_2__) && (defined(__x86_64__) || defined(__i386__))
+  #include <nmmintrin.h>
+  #define CPPS_CRC32C_SSE42 1
+#elif defined(__ARM_FEATURE_CRC32)
+  #include <arm_acle.h>
+  #define CPPS_CRC32C_ARM 1
+#endif
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace cpps::details
+{
+
+//CRC32C (Castagnoli), reflected polynomial
+constexpr std::uint32_t crc32c_polynomial = 0x82F63B78;
+
+//slicing-by-8 tables: table[k][b] is crc of byte b followed by k zero bytes
+constexpr auto crc32c_tables = []
+{
+  std::array<std::array<std::uint32_t, 256>, 8> t{};
+
+  for(std::uint32_t b = 0; b != 256; ++b)
+  {
+    std::uint32_t c = b;
+    for(int i = 0; i != 8; ++i) c = (c >> 1) ^ (crc32c_polynomial & (0u - (c & 1)));
+    t[0][b] = c;
+  }
+
+  for(std::size_t k = 1; k != 8; ++k)
+    for(std::size_t b = 0; b != 256; ++b)
+      t[k][b] = (t[k - 1][b] >> 8) ^ t[0][t[k - 1][b] & 0xFF];
+
+  return t;
+}();
+
+inline std::uint32_t crc32c_update_table(std::uint32_t crc, const std::byte* p, std::size_t n) noexcept
+{
+  const auto& t = crc32c_tables;
+
+  for(; n >= 8; p += 8, n -= 8)
+  {
+    std::uint32_t lo, hi;
+    std::memcpy(&lo, p, 4);
+    std::memcpy(&hi, p + 4, 4);
+
+    //tables are for little endian loads
+    if constexpr(std::endian::native == std::endian::big)
+    {
+      lo = std::byteswap(lo);
+      hi = std::byteswap(hi);
+    }
+
+    lo ^= crc;
+    crc =
+      t[7][lo & 0xFF] ^ t[6][(lo >> 8) & 0xFF] ^ t[5][(lo >> 16) & 0xFF] ^ t[4][lo >> 24] ^
+      t[3][hi & 0xFF] ^ t[2][(hi >> 8) & 0xFF] ^ t[1][(hi >> 16) & 0xFF] ^ t[0][hi >> 24];
+  }
+
+  for(; n != 0; ++p, --n) crc = (crc >> 8) ^ t[0][(crc ^ std::to_integer<std::uint32_t>(*p)) & 0xFF];
+
+  return crc;
+}
+
+inline std::uint32_t crc32c_update(std::uint32_t crc, const std::byte* p, std::size_t n) noexcept
+{
+#if defined(CPPS_CRC32C_SSE42) && defined(__x86_64__)
+  std::uint64_t c = crc;
+  for(; n >= 8; p += 8, n -= 8)
+  {
+    std::uint64_t v;
+    std::memcpy(&v, p, 8);
+    c = _mm_crc32_u64(c, v);
+  }
+
+  crc = static_cast<std::uint32_t>(c);
+  for(; n != 0; ++p, --n) crc = _mm_crc32_u8(crc, std::to_integer<std::uint8_t>(*p));
+
+  return crc;
+#elif defined(CPPS_CRC32C_SSE42)
+  for(; n >= 4; p += 4, n -= 4)
+  {
+    std::uint32_t v;
+    std::memcpy(&v, p, 4);
+    crc = _mm_crc32_u32(crc, v);
+  }
+
+  for(; n != 0; ++p, --n) crc = _mm_crc32_u8(crc, std::to_integer<std::uint8_t>(*p));
+
+  return crc;
+#elif defined(CPPS_CRC32C_ARM) && (defined(__aarch64__) || defined(_M_ARM64))
+  for(; n >= 8; p += 8, n -= 8)
+  {
+    std::uint64_t v;
+    std::memcpy(&v, p, 8);
+    crc = __crc32cd(crc, v);
+  }
+
+  for(; n != 0; ++p, --n) crc = __crc32cb(crc, std::to_integer<std::uint8_t>(*p));
+
+  return crc;
+#else
+  return crc32c_update_table(crc, p, n);
+#endif
+}
+
+inline std::uint32_t crc32c(const void* data, std::size_t n) noexcept
+{
+  return ~crc32c_update(~std::uint32_t(0), static_cast<const std::byte*>(data), n);
+}
+
+//Checksum trailer of datagram, CRC32C of preceding bytes in network byte order
+using checksum_trailer = std::byte[4];
+
+inline void put_checksum(const void* data, std::size_t n, checksum_trailer& out) noexcept
+{
+  const std::uint32_t c = crc32c(data, n);
+  for(unsigned i = 0; i != 4; ++i) out[i] = static_cast<std::byte>(c >> (8 * (3 - i)));
+}
+
+inline bool check_checksum(const void* data, std::size_t n, const checksum_trailer& in) noexcept
+{
+  std::uint32_t c = 0;
+  for(std::byte b : in) c = c << 8 | std::to_integer<std::uint32_t>(b);
+
+  return crc32c(data, n) == c;
+}
+
+} //namespace cpps::details
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "platform_headers.hpp"
+
+#include "socket_resource.hpp"
+
+#if HPP_POSIX_IMPL
+  #include <fcntl.h>
+  #include <cerrno>
+#endif
+
+namespace cpps::details
+{
+
+//returns 0 on success, otherwise error is available through sys_errc::last_error()
+inline int set_nonblocking(socket_resource::Handle h, bool enable) noexcept
+{
+#if HPP_WIN_IMPL
+  u_long mode = enable ? 1 : 0;
+  return ::ioctlsocket(h, FIONBIO, &mode);
+#elif HPP_POSIX_IMPL
+  int flags = ::fcntl(h, F_GETFL, 0);
+
+  if(flags < 0) return flags;
+
+  return ::fcntl(h, F_SETFL, enable ? (flags | O_NONBLOCK) : (flags & ~O_NONBLOCK));
+#endif
+}
+
+//checks last error of socket call on non-blocking socket, must be called right after failed call
+inline bool last_error_would_block() noexcept
+{
+#if HPP_WIN_IMPL
+  return ::WSAGetLastError() == WSAEWOULDBLOCK;
+#elif HPP_POSIX_IMPL
+  return errno == EAGAIN || errno == EWOULDBLOCK;
+#endif
+}
+
+//checks last error of socket call on connected datagram socket, must be called right after failed call:
+//true when earlier datagram was refused by peer host (ICMP port unreachable)
+inline bool last_error_refused() noexcept
+{
+#if HPP_WIN_IMPL
+  return ::WSAGetLastError() == WSAECONNRESET;
+#elif HPP_POSIX_IMPL
+  return errno == ECONNREFUSED;
+#endif
+}
+
+} //namespace cpps::details
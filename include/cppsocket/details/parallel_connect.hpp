@@ -0,0 +1,84 @@
+#pragma once
+
+#include "platform_headers.hpp"
+
+#include <algorithm>
+#include <vector>
+#include "socket_resource.hpp"
+#include "nonblocking.hpp"
+#include "../address.hpp"
+
+#if HPP_POSIX_IMPL
+  #include <cerrno>
+#endif
+
+namespace cpps::details
+{
+
+//error code of last socket call
+inline int last_error_code() noexcept
+{
+  return HPP_IFE(HPP_WIN_IMPL)(::WSAGetLastError())(errno);
+}
+
+constexpr int timed_out_code = HPP_IFE(HPP_WIN_IMPL)(WSAETIMEDOUT)(ETIMEDOUT);
+
+//returned by start_connect while handshake is still running
+constexpr int connect_in_progress = -1;
+
+//puts socket in non-blocking mode and starts connect,
+//returns 0 when connected immediately, connect_in_progress or error code
+template<AddressFamily AF>
+int start_connect(socket_resource::Handle h, const Address<AF>& addr) noexcept
+{
+  if(set_nonblocking(h, true) != 0) return last_error_code();
+
+  if(::connect(h, to_sockaddr_ptr(&addr), sockaddr_length(addr)) == 0) return 0;
+
+  const int err = last_error_code();
+
+  return err == HPP_IFE(HPP_WIN_IMPL)(WSAEWOULDBLOCK)(EINPROGRESS) ? connect_in_progress : err;
+}
+
+//result of connect started by start_connect after socket became writable, 0 on success
+inline int finish_connect(socket_resource::Handle h) noexcept
+{
+  int err = 0;
+  socklen_type len = sizeof(err);
+
+  if(::getsockopt(h, SOL_SOCKET, SO_ERROR, reinterpret_cast<char*>(&err), &len) != 0) return last_error_code();
+  if(err != 0) return err;
+
+  //sockets handed out by Net are blocking
+  return set_nonblocking(h, false) != 0 ? last_error_code() : 0;
+}
+
+//RFC 8305 ordering: alternate native IPv6 and IPv4-mapped candidates,
+//starting with family of first one, order inside each family is preserved
+template<AddressFamily AF>
+std::vector<Address<AF>> interleave_families(std::span<const Address<AF>> addrs)
+{
+  if constexpr(AF != AddressFamily::IPv6)
+    return {addrs.begin(), addrs.end()};
+  else
+  {
+    std::vector<Address<AF>> first, second;
+    const bool mapped_first = !addrs.empty() && addrs.front().is_ipv4_mapped();
+
+    for(const auto& a : addrs)
+      (a.is_ipv4_mapped() == mapped_first ? first : second).push_back(a);
+
+    std::vector<Address<AF>> res;
+    res.reserve(addrs.size());
+
+    for(std::size_t i = 0; i != std::max(first.size(), second.size()); ++i)
+    {
+      if(i < first.size()) res.push_back(first[i]);
+      if(i < second.size()) res.push_back(second[i]);
+    }
+
+    return res;
+  }
+}
+
+} //namespace cpps::details
@@ -11,12 +11,15 @@
   #include <winsock2.h>
   #include <ws2tcpip.h>
   #include <iphlpapi.h>
+  #include <afunix.h>
 
   #pragma comment(lib, "Ws2_32.lib")
 #elif HPP_POSIX_IMPL
   #include <sys/types.h>
   #include <sys/socket.h>
+  #include <sys/un.h>
   #include <arpa/inet.h>
+  #include <netinet/tcp.h>
   #include <netdb.h>
   #include <unistd.h>
   #include <poll.h>
@@ -0,0 +1,272 @@
+#pragma once
+
+#include "platform_headers.hpp"
+
+#include <array>
+#include <bit>
+#include <concepts>
+#include <cstdint>
+#include <string_view>
+
+namespace cpps::details
+{
+
+template<std::integral T>
+constexpr T rt_hton(T hostval) noexcept
+{
+  if constexpr(std::endian::native == std::endian::big)
+    return hostval;
+  else
+    return std::byteswap(hostval);
+}
+
+template<std::integral T>
+constexpr T rt_ntoh(T netval) noexcept
+{
+  return rt_hton(netval);
+}
+
+//longest text produced by formatters, same as INET_ADDRSTRLEN/INET6_ADDRSTRLEN without null
+constexpr std::size_t ipv4_max_string_size = 15;
+constexpr std::size_t ipv6_max_string_size = 45;
+
+//hex digit value or -1, table lookup keeps parsing loop branch light
+constexpr auto rt_hex_table = []
+{
+  std::array<std::int8_t, 256> t{};
+  for(auto& v : t) v = -1;
+  for(unsigned c = '0'; c <= '9'; ++c) t[c] = static_cast<std::int8_t>(c - '0');
+  for(unsigned c = 'a'; c <= 'f'; ++c) t[c] = static_cast<std::int8_t>(c - 'a' + 10);
+  for(unsigned c = 'A'; c <= 'F'; ++c) t[c] = static_cast<std::int8_t>(c - 'A' + 10);
+  return t;
+}();
+
+constexpr int rt_hex_digit(char c) noexcept
+{
+  return rt_hex_table[static_cast<unsigned char>(c)];
+}
+
+//Canonical IPv4 form, also used by ct_inet_pton for literals:
+//four decimal components without leading zeros, each at most 255
+constexpr bool rt_inet_pton4(std::string_view s, std::uint32_t& addr) noexcept
+{
+  std::uint32_t res = 0;
+  std::size_t i = 0;
+
+  for(int part = 0; part != 4; ++part)
+  {
+    if(part != 0)
+    {
+      if(i == s.size() || s[i] != '.') return false;
+      ++i;
+    }
+
+    const std::size_t begin = i;
+    unsigned v = 0;
+
+    while(i != s.size() && i - begin != 3 && s[i] >= '0' && s[i] <= '9')
+      v = v * 10 + static_cast<unsigned>(s[i++] - '0');
+
+    if(i == begin || (s[begin] == '0' && i - begin > 1) || v > 255) return false;
+
+    res = res << 8 | v;
+  }
+
+  if(i != s.size()) return false;
+
+  addr = res;
+
+  return true;
+}
+
+//IPv6 form, also used by ct_inet_pton for literals: hexlets of at most 4 digits,
+//at most one "::" standing for one or more zero hexlets, trailing dotted IPv4 in place of last two hexlets
+constexpr bool rt_inet_pton6(std::string_view s, std::array<std::uint8_t, 16>& addr) noexcept
+{
+  std::array<std::uint16_t, 8> words{};
+  //position of "::" in words, no_gap when there is none
+  constexpr std::size_t no_gap = 8;
+  std::size_t count = 0;
+  std::size_t gap = no_gap;
+  std::size_t i = 0;
+  const std::size_t n = s.size();
+
+  if(s.starts_with("::"))
+  {
+    gap = 0;
+    i = 2;
+  }
+  else if(s.starts_with(':'))
+    return false;
+
+  while(i != n)
+  {
+    if(count == 8) return false;
+
+    const std::size_t begin = i;
+    unsigned v = 0;
+
+    for(int d; i != n && (d = rt_hex_digit(s[i])) >= 0; ++i)
+      v = v << 4 | static_cast<unsigned>(d);
+
+    //digits turned out to be first component of dotted tail
+    if(i != n && s[i] == '.')
+    {
+      std::uint32_t v4 = 0;
+
+      if(count > 6 || !rt_inet_pton4(s.substr(begin), v4)) return false;
+
+      words[count++] = static_cast<std::uint16_t>(v4 >> 16);
+      words[count++] = static_cast<std::uint16_t>(v4);
+      break;
+    }
+
+    if(i == begin || i - begin > 4) return false;
+
+    words[count++] = static_cast<std::uint16_t>(v);
+
+    if(i == n) break;
+    if(s[i] != ':' || ++i == n) return false;
+
+    if(s[i] == ':')
+    {
+      if(gap != no_gap) return false;
+
+      gap = count;
+      ++i;
+    }
+  }
+
+  if(gap == no_gap ? count != 8 : count == 8) return false;
+
+  std::array<std::uint16_t, 8> full{};
+  if(gap == no_gap)
+    full = words;
+  else
+  {
+    for(std::size_t w = 0; w != gap; ++w) full[w] = words[w];
+    for(std::size_t w = gap; w != count; ++w) full[8 - count + w] = words[w];
+  }
+
+  for(std::size_t w = 0; w != 8; ++w)
+  {
+    addr[2 * w]     = static_cast<std::uint8_t>(full[w] >> 8);
+    addr[2 * w + 1] = static_cast<std::uint8_t>(full[w]);
+  }
+
+  return true;
+}
+
+//writes dotted decimal form, returns end of written text, out must have ipv4_max_string_size chars
+constexpr char* rt_inet_ntop4(std::uint32_t addr, char* out) noexcept
+{
+  for(int shift = 24; shift >= 0; shift -= 8)
+  {
+    const unsigned v = (addr >> shift) & 0xFF;
+
+    if(v >= 100) *out++ = static_cast<char>('0' + v / 100);
+    if(v >= 10)  *out++ = static_cast<char>('0' + v / 10 % 10);
+    *out++ = static_cast<char>('0' + v % 10);
+
+    if(shift != 0) *out++ = '.';
+  }
+
+  return out;
+}
+
+//writes RFC 5952 form: lowercase, longest run of two or more zero hexlets compressed,
+//IPv4-mapped addresses with dotted tail; out must have ipv6_max_string_size chars
+constexpr char* rt_inet_ntop6(const std::array<std::uint8_t, 16>& addr, char* out) noexcept
+{
+  constexpr char hex[] = "0123456789abcdef";
+
+  std::array<unsigned, 8> words{};
+  for(std::size_t w = 0; w != 8; ++w) words[w] = static_cast<unsigned>(addr[2 * w] << 8 | addr[2 * w + 1]);
+
+  if(words[0] == 0 && words[1] == 0 && words[2] == 0 && words[3] == 0 && words[4] == 0 && words[5] == 0xFFFF)
+  {
+    for(char c : std::string_view("::ffff:")) *out++ = c;
+
+    return rt_inet_ntop4(static_cast<std::uint32_t>(words[6] << 16 | words[7]), out);
+  }
+
+  //start of compressed run, 8 when no run is compressed
+  std::size_t best = 8, best_len = 1;
+  for(std::size_t w = 0; w != 8;)
+  {
+    std::size_t len = 0;
+    while(w + len != 8 && words[w + len] == 0) ++len;
+
+    if(len > best_len)
+    {
+      best = w;
+      best_len = len;
+    }
+
+    w += len != 0 ? len : 1;
+  }
+
+  for(std::size_t w = 0; w != 8; ++w)
+  {
+    if(w == best)
+    {
+      *out++ = ':';
+      w += best_len - 1;
+      if(w == 7) *out++ = ':';
+      continue;
+    }
+
+    if(w != 0) *out++ = ':';
+
+    bool leading = true;
+    for(int shift = 12; shift >= 0; shift -= 4)
+    {
+      const unsigned d = (words[w] >> shift) & 0xF;
+      if(leading && d == 0 && shift != 0) continue;
+
+      leading = false;
+      *out++ = hex[d];
+    }
+  }
+
+  return out;
+}
+
+//port in decimal, 0-65535
+constexpr bool rt_parse_port(std::string_view s, std::uint16_t& port) noexcept
+{
+  if(s.empty() || s.size() > 5) return false;
+
+  unsigned v = 0;
+  for(char c : s)
+  {
+    if(c < '0' || c > '9') return false;
+    v = v * 10 + static_cast<unsigned>(c - '0');
+  }
+
+  if(v > 0xFFFF) return false;
+
+  port = static_cast<std::uint16_t>(v);
+
+  return true;
+}
+
+//writes decimal port, out must have 5 chars
+constexpr char* rt_format_port(std::uint16_t port, char* out) noexcept
+{
+  char digits[5];
+  int n = 0;
+
+  do
+  {
+    digits[n++] = static_cast<char>('0' + port % 10);
+    port /= 10;
+  }
+  while(port != 0);
+
+  while(n != 0) *out++ = digits[--n];
+
+  return out;
+}
+
+} //namespace cpps::details
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <optional>
+#include <utility>
+#include "socket_resource.hpp"
+#include "cppsocket/socket.hpp"
+
+namespace cpps::details
+{
+
+//gives library components access to socket internals without widening Socket public interface
+struct socket_access
+{
+  template<SocketInfo SI, InvInfo INV, ConnectionSettings CS>
+  static socket_resource::Handle handle(const Socket<SI, INV, CS>& s) noexcept
+  {
+    return s.m_handle_;
+  }
+
+  template<SocketInfo SI, InvInfo INV, ConnectionSettings CS>
+  static std::optional<sys_errc::ErrorCode> exchange_hello(Socket<SI, INV, CS>& s) noexcept
+  {
+    return s.exchange_hello();
+  }
+
+  template<typename S>
+  static S make(socket_resource&& handle) noexcept
+  {
+    return S(std::move(handle));
+  }
+};
+
+} //namespace cpps::details
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+namespace cpps::details
+{
+
+constexpr std::size_t cache_line_size = 64;
+
+//bounded lock-free single producer single consumer queue
+template<typename T>
+class spsc_queue
+{
+  struct slot
+  {
+    alignas(T) std::byte data[sizeof(T)];
+  };
+
+  std::size_t m_mask_;
+  std::unique_ptr<slot[]> m_slots_;
+
+  //each side caches other side index to touch shared cache line only when needed
+  alignas(cache_line_size) std::atomic<std::size_t> m_tail_ = 0;
+  std::size_t m_cached_head_ = 0;
+
+  alignas(cache_line_size) std::atomic<std::size_t> m_head_ = 0;
+  std::size_t m_cached_tail_ = 0;
+
+  T* at(std::size_t i) noexcept
+  {
+    return std::launder(reinterpret_cast<T*>(m_slots_[i & m_mask_].data));
+  }
+
+public:
+  //capacity is rounded up to power of two
+  explicit spsc_queue(std::size_t capacity) :
+    m_mask_(std::bit_ceil((std::max)(capacity, std::size_t{2})) - 1),
+    m_slots_(std::make_unique<slot[]>(m_mask_ + 1)) {}
+
+  spsc_queue(const spsc_queue&) = delete;
+  spsc_queue& operator=(const spsc_queue&) = delete;
+
+  ~spsc_queue()
+  {
+    while(pop());
+  }
+
+  std::size_t capacity() const noexcept { return m_mask_ + 1; }
+
+  //producer side, conservative: can report full while consumer is freeing slots
+  bool full() noexcept
+  {
+    const auto tail = m_tail_.load(std::memory_order_relaxed);
+
+    if(tail - m_cached_head_ <= m_mask_) return false;
+
+    m_cached_head_ = m_head_.load(std::memory_order_acquire);
+
+    return tail - m_cached_head_ > m_mask_;
+  }
+
+  //producer side
+  template<typename U>
+  bool push(U&& value) noexcept(std::is_nothrow_constructible_v<T, U&&>)
+  {
+    if(full()) return false;
+
+    const auto tail = m_tail_.load(std::memory_order_relaxed);
+
+    ::new(m_slots_[tail & m_mask_].data) T(std::forward<U>(value));
+
+    m_tail_.store(tail + 1, std::memory_order_release);
+
+    return true;
+  }
+
+  //consumer side
+  std::optional<T> pop() noexcept(std::is_nothrow_move_constructible_v<T>)
+  {
+    const auto head = m_head_.load(std::memory_order_relaxed);
+
+    if(head == m_cached_tail_)
+    {
+      m_cached_tail_ = m_tail_.load(std::memory_order_acquire);
+
+      if(head == m_cached_tail_) return std::nullopt;
+    }
+
+    T* p = at(head);
+    std::optional<T> r(std::move(*p));
+    p->~T();
+
+    m_head_.store(head + 1, std::memory_order_release);
+
+    return r;
+  }
+};
+
+} //namespace cpps::details
@@ -0,0 +1,142 @@
+#pragma once
+
+#include "platform_headers.hpp"
+
+#include <array>
+#include <bit>
+#include <cstring>
+#include <span>
+#include "batch_io.hpp"
+#include "convert_byte_order.hpp"
+#include "socket_resource.hpp"
+#include "cppsocket/var_packet.hpp"
+
+namespace cpps::details
+{
+
+//elements are sent without copy unless their byte order has to be converted
+template<typename E, bool Convert>
+constexpr bool tail_needs_conversion = Convert && std::endian::native == std::endian::little && sizeof(E) != 1;
+
+//elements converted at once when tail is sent to stream
+constexpr std::size_t var_packet_chunk_size = 4096;
+
+template<var_packet_type VP, bool Convert>
+std::array<std::byte, VP::tail_offset> encode_var_prefix(const typename VP::header_type& header, std::size_t count) noexcept
+{
+  std::array<std::byte, VP::tail_offset> prefix{};
+
+  cpps::uint32_t n{static_cast<std::uint32_t>(count)};
+  typename VP::header_type h = header;
+
+  if constexpr(Convert)
+  {
+    convert_byte_order(n);
+    convert_byte_order(h);
+  }
+
+  std::memcpy(prefix.data(), &n, sizeof(n));
+  std::memcpy(prefix.data() + VP::header_offset, &h, sizeof(h));
+
+  return prefix;
+}
+
+//element count and header of received prefix, false when count exceeds max_count
+template<var_packet_type VP, bool Convert>
+bool decode_var_prefix(const std::byte* data, std::size_t& count, typename VP::header_type& header) noexcept
+{
+  cpps::uint32_t n;
+
+  std::memcpy(&n, data, sizeof(n));
+  std::memcpy(&header, data + VP::header_offset, sizeof(header));
+
+  if constexpr(Convert)
+  {
+    convert_byte_order(n);
+    convert_byte_order(header);
+  }
+
+  count = n;
+
+  return count <= VP::max_count;
+}
+
+//converts received elements in place, buffer is aligned for them
+template<typename E, bool Convert>
+std::span<const E> decode_var_tail(std::byte* data, std::size_t count) noexcept
+{
+  E* tail = reinterpret_cast<E*>(data);
+
+  if constexpr(tail_needs_conversion<E, Convert>)
+    for(std::size_t i = 0; i != count; ++i) convert_byte_order(tail[i]);
+
+  return {tail, count};
+}
+
+//sends var_packet as one datagram (to addr, or to connected peer when addr is null) or to stream,
+//returns false on error
+template<var_packet_type VP, bool Convert, bool Stream>
+bool send_var_packet(
+  socket_resource::Handle h,
+  const typename VP::header_type& header,
+  std::span<const typename VP::element_type> tail,
+  const sockaddr* addr = nullptr,
+  socklen_type addrlen = 0) noexcept
+{
+  using E = typename VP::element_type;
+
+  const auto prefix = encode_var_prefix<VP, Convert>(header, tail.size());
+
+  if constexpr(!tail_needs_conversion<E, Convert>)
+  {
+    const const_buffer bufs[] = {{prefix.data(), prefix.size()}, {tail.data(), tail.size_bytes()}};
+
+    if constexpr(Stream)
+      return send_all(h, bufs, 2);
+    else
+      return send_gathered_datagram(h, bufs, 2, addr, addrlen);
+  }
+  else if constexpr(Stream)
+  {
+    //stream tail is converted and sent chunk by chunk, first chunk goes with prefix
+    constexpr std::size_t chunk = var_packet_chunk_size / sizeof(E);
+    E converted[chunk];
+
+    std::size_t sent = 0;
+    do
+    {
+      const std::size_t n = (std::min)(chunk, tail.size() - sent);
+      for(std::size_t i = 0; i != n; ++i)
+      {
+        converted[i] = tail[sent + i];
+        convert_byte_order(converted[i]);
+      }
+
+      const const_buffer bufs[] = {{prefix.data(), prefix.size()}, {converted, n * sizeof(E)}};
+
+      if(!send_all(h, sent == 0 ? bufs : bufs + 1, sent == 0 ? 2 : 1)) return false;
+
+      sent += n;
+    }
+    while(sent != tail.size());
+
+    return true;
+  }
+  else
+  {
+    static_assert(VP::max_size <= 65535, "var_packet does not fit datagram");
+
+    E converted[VP::max_count == 0 ? 1 : VP::max_count];
+    for(std::size_t i = 0; i != tail.size(); ++i)
+    {
+      converted[i] = tail[i];
+      convert_byte_order(converted[i]);
+    }
+
+    const const_buffer bufs[] = {{prefix.data(), prefix.size()}, {converted, tail.size_bytes()}};
+
+    return send_gathered_datagram(h, bufs, 2, addr, addrlen);
+  }
+}
+
+} //namespace cpps::details
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "platform_headers.hpp"
+
+#include <cstdint>
+#include "socket_resource.hpp"
+#include "nonblocking.hpp"
+
+#if defined(__linux__)
+  #include <sys/eventfd.h>
+#elif HPP_POSIX_IMPL
+  #include <netinet/in.h>
+#endif
+
+namespace cpps::details
+{
+
+//Pollable handle one thread signals to wake another blocked in poll on it.
+//eventfd on Linux, elsewhere loopback datagram socket connected to itself, so it works with WSAPoll too
+class wakeup
+{
+  socket_resource m_handle_ = socket_resource::INVALID_HANDLE;
+
+public:
+  //returns false on error
+  bool open() noexcept
+  {
+#if defined(__linux__)
+    m_handle_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+    return !m_handle_.is_invalid();
+#else
+    m_handle_ = ::socket(AF_INET, SOCK_DGRAM, 0);
+
+    if(m_handle_.is_invalid()) return false;
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = ::htonl(INADDR_LOOPBACK);
+    socklen_type len = sizeof(addr);
+
+    return
+      ::bind(m_handle_, reinterpret_cast<sockaddr*>(&addr), len) == 0 &&
+      ::getsockname(m_handle_, reinterpret_cast<sockaddr*>(&addr), &len) == 0 &&
+      ::connect(m_handle_, reinterpret_cast<sockaddr*>(&addr), len) == 0 &&
+      set_nonblocking(m_handle_, true) == 0;
+#endif
+  }
+
+  socket_resource::Handle handle() const noexcept
+  {
+    return m_handle_;
+  }
+
+  //failure means wakeup is already pending
+  void signal() noexcept
+  {
+#if defined(__linux__)
+    const std::uint64_t one = 1;
+    [[maybe_unused]] auto r = ::write(m_handle_, &one, sizeof(one));
+#else
+    const char c = 0;
+    ::send(m_handle_, &c, 1, 0);
+#endif
+  }
+
+  //consumes pending wakeups
+  void clear() noexcept
+  {
+#if defined(__linux__)
+    std::uint64_t count;
+    [[maybe_unused]] auto r = ::read(m_handle_, &count, sizeof(count));
+#else
+    char c;
+    while(::recv(m_handle_, &c, 1, 0) >= 0);
+#endif
+  }
+};
+
+} //namespace cpps::details
@@ -0,0 +1,247 @@
+#pragma once
+
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+#include <aggr_refl/aggregate_reflection.hpp>
+#include "cppsocket/fixed_t.hpp"
+#include "apply_index.hpp"
+#include "convert_byte_order.hpp"
+
+namespace cpps::details
+{
+
+template<std::unsigned_integral U>
+constexpr std::size_t max_varint_size = (sizeof(U) * 8 + 6) / 7;
+
+//LEB128: 7 bits per byte, least significant group first, high bit marks continuation
+template<std::unsigned_integral U>
+constexpr std::byte* put_varint(U v, std::byte* out) noexcept
+{
+  while(v >= 0x80)
+  {
+    *out++ = static_cast<std::byte>(v | 0x80);
+    v >>= 7;
+  }
+
+  *out++ = static_cast<std::byte>(v);
+
+  return out;
+}
+
+//returns end of varint or nullptr when it is truncated or does not fit U
+template<std::unsigned_integral U>
+constexpr const std::byte* get_varint(const std::byte* in, const std::byte* end, U& v) noexcept
+{
+  constexpr unsigned bits = sizeof(U) * 8;
+
+  v = 0;
+  for(unsigned shift = 0; in != end && shift < bits; shift += 7)
+  {
+    const auto b = std::to_integer<unsigned>(*in++);
+    const U group = static_cast<U>(b & 0x7F);
+
+    if(bits - shift < 7 && (group >> (bits - shift)) != 0) return nullptr;
+
+    v |= static_cast<U>(group << shift);
+
+    if((b & 0x80) == 0) return in;
+  }
+
+  return nullptr;
+}
+
+//maps small negative and positive values to small unsigned ones: 0, -1, 1, -2 -> 0, 1, 2, 3
+template<std::unsigned_integral U>
+constexpr U zigzag(U u) noexcept
+{
+  return static_cast<U>(u << 1) ^ static_cast<U>(U(0) - (u >> (sizeof(U) * 8 - 1)));
+}
+
+template<std::unsigned_integral U>
+constexpr U unzigzag(U u) noexcept
+{
+  return static_cast<U>(u >> 1) ^ static_cast<U>(U(0) - (u & 1));
+}
+
+//Largest encoded size of packet: varint per integer field, floating point fields as is
+template<typename T>
+struct max_encoded_size;
+
+template<typename T>
+struct max_encoded_size<fixed_t<T>>
+{
+  static constexpr std::size_t value = [] {
+    if constexpr(std::integral<T>)
+      return max_varint_size<std::make_unsigned_t<T>>;
+    else
+      return sizeof(T);
+  }();
+};
+
+template<typename T, std::size_t N>
+struct max_encoded_size<T[N]>
+{
+  static constexpr std::size_t value = N * max_encoded_size<T>::value;
+};
+
+template<typename T>
+  requires std::is_class_v<T>
+struct max_encoded_size<T>
+{
+  static constexpr std::size_t value = apply_index<aggr_refl::tuple_size_v<T>>([](auto... Is)
+  {
+    return (std::size_t(0) + ... + max_encoded_size<aggr_refl::tuple_element_t<Is, T>>::value);
+  });
+};
+
+template<typename T>
+constexpr std::size_t max_encoded_size_v = max_encoded_size<T>::value;
+
+//Encodes value, with prev integer fields are sent as wrapping difference to prev fields.
+//Signed fields and differences are zigzag encoded, floating point fields go in network byte order
+template<typename T>
+constexpr std::byte* encode_value(const fixed_t<T>& v, const fixed_t<T>* prev, std::byte* out) noexcept
+{
+  if constexpr(std::integral<T>)
+  {
+    using U = std::make_unsigned_t<T>;
+
+    U u = static_cast<U>(v.underlying_value());
+
+    if(prev) return put_varint(zigzag(static_cast<U>(u - static_cast<U>(prev->underlying_value()))), out);
+
+    return put_varint(std::signed_integral<T> ? zigzag(u) : u, out);
+  }
+  else
+  {
+    fixed_t<T> t = v;
+    convert_byte_order(t);
+    std::memcpy(out, &t, sizeof(t));
+
+    return out + sizeof(t);
+  }
+}
+
+template<typename T, std::size_t N>
+constexpr std::byte* encode_value(const T (&v)[N], const T (*prev)[N], std::byte* out) noexcept
+{
+  for(std::size_t i = 0; i != N; ++i) out = encode_value(v[i], prev ? &(*prev)[i] : nullptr, out);
+
+  return out;
+}
+
+template<typename T>
+  requires std::is_class_v<T>
+constexpr std::byte* encode_value(const T& v, const T* prev, std::byte* out) noexcept
+{
+  apply_index<aggr_refl::tuple_size_v<T>>([&](auto... Is) noexcept
+  {
+    ((out = encode_value(
+      aggr_refl::get<Is>(const_cast<T&>(v)),
+      prev ? &aggr_refl::get<Is>(const_cast<T&>(*prev)) : nullptr,
+      out)), ...);
+  });
+
+  return out;
+}
+
+//Decodes value written by encode_value with same prev, returns nullptr on malformed input
+template<typename T>
+constexpr const std::byte* decode_value(fixed_t<T>& v, const fixed_t<T>* prev, const std::byte* in, const std::byte* end) noexcept
+{
+  if(!in) return nullptr;
+
+  if constexpr(std::integral<T>)
+  {
+    using U = std::make_unsigned_t<T>;
+
+    U u;
+    in = get_varint(in, end, u);
+
+    if(prev)
+      u = static_cast<U>(static_cast<U>(prev->underlying_value()) + unzigzag(u));
+    else if constexpr(std::signed_integral<T>)
+      u = unzigzag(u);
+
+    v = fixed_t<T>{static_cast<T>(u)};
+
+    return in;
+  }
+  else
+  {
+    if(static_cast<std::size_t>(end - in) < sizeof(v)) return nullptr;
+
+    std::memcpy(&v, in, sizeof(v));
+    convert_byte_order(v);
+
+    return in + sizeof(v);
+  }
+}
+
+template<typename T, std::size_t N>
+constexpr const std::byte* decode_value(T (&v)[N], const T (*prev)[N], const std::byte* in, const std::byte* end) noexcept
+{
+  for(std::size_t i = 0; i != N; ++i) in = decode_value(v[i], prev ? &(*prev)[i] : nullptr, in, end);
+
+  return in;
+}
+
+template<typename T>
+  requires std::is_class_v<T>
+constexpr const std::byte* decode_value(T& v, const T* prev, const std::byte* in, const std::byte* end) noexcept
+{
+  apply_index<aggr_refl::tuple_size_v<T>>([&](auto... Is) noexcept
+  {
+    ((in = decode_value(
+      aggr_refl::get<Is>(v),
+      prev ? &aggr_refl::get<Is>(const_cast<T&>(*prev)) : nullptr,
+      in, end)), ...);
+  });
+
+  return in;
+}
+
+//length prefix of encoded packet on stream, wide enough for largest encoding
+template<typename T>
+using encoded_length_t =
+  std::conditional_t<(max_encoded_size_v<T> <= 0xFF), std::uint8_t,
+  std::conditional_t<(max_encoded_size_v<T> <= 0xFFFF), std::uint16_t, std::uint32_t>>;
+
+//Previous packet of each type sent and received on connection, for delta encoding
+struct delta_state
+{
+  template<typename T>
+  T& sent() { return get<T>(m_sent_); }
+
+  template<typename T>
+  T& received() { return get<T>(m_received_); }
+
+private:
+  template<typename T>
+  static constexpr char type_key = 0;
+
+  using storage = std::unordered_map<const void*, std::vector<std::byte>>;
+
+  //first packet of type is encoded against zero packet
+  template<typename T>
+  static T& get(storage& s)
+  {
+    auto& bytes = s[&type_key<T>];
+    if(bytes.empty()) bytes.resize(sizeof(T));
+
+    return *reinterpret_cast<T*>(bytes.data());
+  }
+
+  storage m_sent_;
+  storage m_received_;
+};
+
+struct no_delta_state {};
+
+} //namespace cpps::details
@@ -0,0 +1,166 @@
+#pragma once
+
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <cstring>
+#include <optional>
+#include <type_traits>
+#include <aggr_refl/aggregate_reflection.hpp>
+#include "packet.hpp"
+#include "details/apply_index.hpp"
+#include "details/convert_byte_order.hpp"
+#include "details/crc32c.hpp"
+
+namespace cpps
+{
+
+//packet_type is checked on instantiation, so packet can name its view while incomplete
+template<typename T>
+class lazy_packet;
+
+namespace details
+{
+
+struct lazy_packet_access;
+
+} //namespace details
+
+//Packet validating itself against lazy view, so validation converts only fields it reads:
+//static bool is_valid(const lazy_packet<T>&) noexcept next to usual is_valid
+template<typename T>
+concept lazy_validated_packet =
+  packet_type<T> &&
+  requires(const lazy_packet<T>& p)
+  {
+    { T::is_valid(p) } noexcept -> std::same_as<bool>;
+  };
+
+//Received packet kept as it came from wire, field byte order is converted on each access,
+//so handler reading few fields of wide packet does not pay for converting whole packet.
+//Returned only by receiving functions after successful validation
+template<typename T>
+class lazy_packet
+{
+  static_assert(packet_type<T>);
+
+  friend struct details::lazy_packet_access;
+
+  template<std::size_t I>
+  using field_type = aggr_refl::tuple_element_t<I, T>;
+
+  //packet has no padding, field starts right after previous one
+  template<std::size_t I>
+  static constexpr std::size_t offset = details::apply_index<I>([](auto... Is)
+  {
+    return (std::size_t(0) + ... + sizeof(field_type<Is>));
+  });
+
+  template<typename F>
+  F load(std::size_t off) const noexcept
+  {
+    F f;
+    std::memcpy(&f, m_data_ + off, sizeof(F));
+
+    if(m_convert_)
+      details::convert_byte_order(f);
+
+    return f;
+  }
+
+  bool is_valid() const noexcept
+  {
+    if constexpr(lazy_validated_packet<T>)
+      return T::is_valid(*this);
+    else
+      return load<T>(0).is_valid();
+  }
+
+  explicit lazy_packet(bool convert) noexcept : m_convert_(convert) {}
+
+  //room for checksum trailer, extra byte detects oversized datagram
+  alignas(T) std::byte m_data_[sizeof(T) + sizeof(details::checksum_trailer) + 1];
+  bool m_convert_;
+
+public:
+  static constexpr std::size_t field_count = aggr_refl::tuple_size_v<T>;
+
+  //field I, array field is returned as std::array
+  template<std::size_t I>
+  auto get() const noexcept
+  {
+    using F = field_type<I>;
+
+    if constexpr(std::is_array_v<F>)
+    {
+      static_assert(std::rank_v<F> == 1, "use get<I>(index) for multidimensional array fields");
+
+      using E = std::remove_extent_t<F>;
+
+      std::array<E, std::extent_v<F>> a;
+      std::memcpy(a.data(), m_data_ + offset<I>, sizeof(F));
+
+      if(m_convert_)
+        for(auto& e : a) details::convert_byte_order(e);
+
+      return a;
+    }
+    else
+      return load<F>(offset<I>);
+  }
+
+  //element of array field I, only this element is converted.
+  //Multidimensional array is indexed as flat one in row-major order, empty when index is out of range
+  template<std::size_t I>
+    requires std::is_array_v<field_type<I>>
+  std::optional<std::remove_all_extents_t<field_type<I>>> get(std::size_t index) const noexcept
+  {
+    using E = std::remove_all_extents_t<field_type<I>>;
+
+    if(index >= sizeof(field_type<I>) / sizeof(E)) return std::nullopt;
+
+    return load<E>(offset<I> + index * sizeof(E));
+  }
+
+  //whole packet converted at once
+  valid_packet<T> decode() const noexcept
+  {
+    return std::bit_cast<valid_packet<T>>(load<T>(0));
+  }
+};
+
+namespace details
+{
+
+//lets receiving functions fill lazy_packet in place
+struct lazy_packet_access
+{
+  template<packet_type T>
+  static lazy_packet<T> make(bool convert) noexcept
+  {
+    return lazy_packet<T>(convert);
+  }
+
+  template<packet_type T>
+  static std::byte* data(lazy_packet<T>& p) noexcept
+  {
+    return p.m_data_;
+  }
+
+  //checksum trailer follows packet
+  template<packet_type T>
+  static bool check_checksum(const lazy_packet<T>& p) noexcept
+  {
+    return details::check_checksum(p.m_data_, sizeof(T), reinterpret_cast<const checksum_trailer&>(p.m_data_[sizeof(T)]));
+  }
+
+  template<packet_type T>
+  static bool is_valid(const lazy_packet<T>& p) noexcept
+  {
+    return p.is_valid();
+  }
+};
+
+} //namespace details
+
+} //namespace cpps
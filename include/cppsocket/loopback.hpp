@@ -0,0 +1,974 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <queue>
+#include <span>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "socket.hpp"
+
+namespace cpps
+{
+
+struct LoopbackSettings
+{
+  std::uint64_t latency_ns = 0;
+  //uniform random extra delay in [0, jitter_ns]
+  std::uint64_t jitter_ns = 0;
+
+  //datagram only, stream connections are reliable and ordered
+  double loss = 0;
+  double reorder = 0;
+  std::uint64_t reorder_delay_ns = 0;
+
+  std::uint64_t seed = 1;
+};
+
+template<AddressFamily AF>
+class LoopbackNetwork;
+
+template<SocketInfo SI, InvInfo INV, ConnectionSettings SCS>
+class LoopbackSocket;
+
+template<SocketInfo SI, InvInfo INV, ConnectionSettings CS>
+struct LoopbackIncomingConnection
+{
+  LoopbackSocket<SI, INV, CS> sock;
+  Address<SI.address_family> addr;
+};
+
+namespace details
+{
+
+//address given to n-th simulated socket which was not bound explicitly
+template<AddressFamily AF>
+Address<AF> loopback_ephemeral_address(std::uint32_t n) noexcept
+{
+  constexpr auto to_network = [](auto v)
+  {
+    if constexpr(std::endian::native == std::endian::little)
+      return std::byteswap(v);
+    else
+      return v;
+  };
+
+  sockaddr_type<AF> s{};
+
+  if constexpr(AF == AddressFamily::IPv4)
+  {
+    //127.0.0.0/8 with ports 10000-59999
+    s.sin_family = AF_INET;
+    s.sin_port = to_network(static_cast<std::uint16_t>(10000 + n % 50000));
+    s.sin_addr.s_addr = to_network(static_cast<std::uint32_t>(0x7F000000 | (n / 50000 + 1)));
+
+    return from_sockaddr(s);
+  }
+
+  if constexpr(AF == AddressFamily::IPv6)
+  {
+    //fd00::/8 unique local range, one address per socket
+    s.sin6_family = AF_INET6;
+    s.sin6_port = to_network(std::uint16_t{10000});
+    s.sin6_addr.s6_addr[0] = 0xFD;
+    for(int i = 0; i != 4; ++i) s.sin6_addr.s6_addr[15 - i] = static_cast<std::uint8_t>(n >> (8 * i));
+
+    return from_sockaddr(s);
+  }
+
+  if constexpr(AF == AddressFamily::Unix)
+  {
+    //abstract name like linux autobind
+    constexpr char hex[] = "0123456789abcdef";
+    constexpr std::size_t prefix = 5;
+
+    s.sun_family = AF_UNIX;
+    std::memcpy(s.sun_path + 1, "cpps-", prefix);
+    for(int i = 0; i != 8; ++i) s.sun_path[1 + prefix + i] = hex[(n >> (28 - 4 * i)) & 0xF];
+
+    return from_sockaddr(s, static_cast<socklen_type>(offsetof(sockaddr_type<AF>, sun_path) + 1 + prefix + 8));
+  }
+}
+
+} //namespace details
+
+//In-process simulated network for benchmarks and simulations of handler logic without kernel.
+//Sockets created by it mirror Socket API (same SocketInfo/InvInfo states, packet validation, recvfrom results),
+//messages travel through in-memory queues with configurable latency, jitter, loss and reordering
+//and are delivered only when virtual clock is advanced, so runs are deterministic for given seed.
+//Receiving from empty queue fails with operation_would_block instead of blocking, poll advances virtual clock.
+//Not thread safe, network must outlive its sockets.
+template<AddressFamily AF>
+class LoopbackNetwork
+{
+  template<SocketInfo, InvInfo, ConnectionSettings>
+  friend class LoopbackSocket;
+
+  static constexpr std::uint32_t none = (std::numeric_limits<std::uint32_t>::max)();
+
+  enum class message_kind : std::uint8_t
+  {
+    data,
+    connect,
+    fin,
+  };
+
+  //messages are pooled, payload buffers are reused after delivery
+  struct message
+  {
+    std::vector<std::byte> data;
+    std::optional<Address<AF>> from;
+    std::uint32_t dst = none;
+    std::uint32_t dst_generation = 0;
+    std::uint32_t conn = none;
+    std::uint32_t next = none;
+    message_kind kind = message_kind::data;
+  };
+
+  struct endpoint
+  {
+    std::optional<Address<AF>> addr;
+    //connected datagram socket accepts only messages from peer_addr
+    std::optional<Address<AF>> peer_addr;
+    std::uint32_t peer = none;
+    std::uint32_t peer_generation = 0;
+
+    std::uint32_t generation = 0;
+    std::uint32_t inbox_head = none;
+    std::uint32_t inbox_tail = none;
+    //stream only: bytes consumed from head message and bytes available in inbox
+    std::size_t head_offset = 0;
+    std::size_t available = 0;
+
+    //stream only: keeps delivery order under jitter
+    std::uint64_t last_delivery = 0;
+
+    unsigned backlog = 0;
+    unsigned max_backlog = 0;
+
+    bool open = false;
+    bool bound = false;
+    bool stream = false;
+    bool listening = false;
+    bool peer_closed = false;
+  };
+
+  struct event
+  {
+    std::uint64_t time;
+    std::uint64_t seq;
+    std::uint32_t msg;
+
+    constexpr bool operator>(const event& e) const noexcept
+    {
+      return time != e.time ? time > e.time : seq > e.seq;
+    }
+  };
+
+  LoopbackSettings m_settings_;
+  std::uint64_t m_now_ = 0;
+  std::uint64_t m_seq_ = 0;
+  std::uint64_t m_rng_;
+  std::uint32_t m_ephemeral_ = 0;
+  std::uint64_t m_delivered_ = 0;
+  std::uint64_t m_dropped_ = 0;
+
+  std::vector<endpoint> m_endpoints_;
+  std::vector<std::uint32_t> m_free_endpoints_;
+  std::vector<message> m_messages_;
+  std::vector<std::uint32_t> m_free_messages_;
+  std::priority_queue<event, std::vector<event>, std::greater<>> m_events_;
+  std::unordered_map<Address<AF>, std::uint32_t> m_bound_;
+
+  //splitmix64
+  std::uint64_t random() noexcept
+  {
+    std::uint64_t z = (m_rng_ += 0x9E3779B97F4A7C15);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EB;
+    return z ^ (z >> 31);
+  }
+
+  bool chance(double p) noexcept
+  {
+    return p > 0 && static_cast<double>(random() >> 11) * 0x1.0p-53 < p;
+  }
+
+  std::uint32_t alloc_message()
+  {
+    if(m_free_messages_.empty())
+    {
+      m_messages_.emplace_back();
+      return static_cast<std::uint32_t>(m_messages_.size() - 1);
+    }
+
+    const std::uint32_t i = m_free_messages_.back();
+    m_free_messages_.pop_back();
+
+    return i;
+  }
+
+  void free_message(std::uint32_t i)
+  {
+    message& m = m_messages_[i];
+    m.data.clear();
+    m.from.reset();
+    m.conn = m.next = none;
+    m.kind = message_kind::data;
+
+    m_free_messages_.push_back(i);
+  }
+
+  std::uint32_t open_endpoint(bool stream)
+  {
+    std::uint32_t i;
+
+    if(m_free_endpoints_.empty())
+    {
+      m_endpoints_.emplace_back();
+      i = static_cast<std::uint32_t>(m_endpoints_.size() - 1);
+    }
+    else
+    {
+      i = m_free_endpoints_.back();
+      m_free_endpoints_.pop_back();
+    }
+
+    endpoint& e = m_endpoints_[i];
+    e.open = true;
+    e.stream = stream;
+
+    return i;
+  }
+
+  bool bind(std::uint32_t id, const Address<AF>& addr)
+  {
+    if(!m_bound_.try_emplace(addr, id).second) return false;
+
+    m_endpoints_[id].addr = addr;
+    m_endpoints_[id].bound = true;
+
+    return true;
+  }
+
+  void bind_ephemeral(std::uint32_t id)
+  {
+    while(!bind(id, details::loopback_ephemeral_address<AF>(m_ephemeral_++)));
+  }
+
+  std::uint32_t inbox_pop(std::uint32_t id) noexcept
+  {
+    endpoint& e = m_endpoints_[id];
+    const std::uint32_t i = e.inbox_head;
+
+    e.inbox_head = m_messages_[i].next;
+    if(e.inbox_head == none) e.inbox_tail = none;
+    e.head_offset = 0;
+
+    return i;
+  }
+
+  void close_endpoint(std::uint32_t id)
+  {
+    endpoint& e = m_endpoints_[id];
+
+    if(e.stream && e.peer != none && !e.peer_closed)
+    {
+      const std::uint32_t m = alloc_message();
+      m_messages_[m].kind = message_kind::fin;
+      schedule(m, id, e.peer, e.peer_generation);
+    }
+
+    while(e.inbox_head != none)
+    {
+      const std::uint32_t m = inbox_pop(id);
+
+      //connection accepted by nobody is closed together with listener
+      if(m_messages_[m].kind == message_kind::connect) close_endpoint(m_messages_[m].conn);
+
+      free_message(m);
+    }
+
+    if(e.bound) m_bound_.erase(*e.addr);
+
+    const std::uint32_t generation = e.generation + 1;
+    e = endpoint{};
+    e.generation = generation;
+
+    m_free_endpoints_.push_back(id);
+  }
+
+  void schedule(std::uint32_t msg, std::uint32_t src, std::uint32_t dst, std::uint32_t dst_generation)
+  {
+    endpoint& s = m_endpoints_[src];
+    message& m = m_messages_[msg];
+
+    m.dst = dst;
+    m.dst_generation = dst_generation;
+
+    std::uint64_t delay = m_settings_.latency_ns;
+    if(m_settings_.jitter_ns != 0) delay += random() % (m_settings_.jitter_ns + 1);
+
+    if(!s.stream)
+    {
+      if(chance(m_settings_.loss))
+      {
+        ++m_dropped_;
+        free_message(msg);
+        return;
+      }
+
+      if(chance(m_settings_.reorder)) delay += m_settings_.reorder_delay_ns;
+    }
+
+    std::uint64_t time = m_now_ + delay;
+
+    if(s.stream)
+    {
+      time = (std::max)(time, s.last_delivery);
+      s.last_delivery = time;
+    }
+
+    m_events_.push({time, m_seq_++, msg});
+  }
+
+  //datagram is dropped if nobody is bound to destination, like unreachable udp port
+  void send_datagram(std::uint32_t src, const Address<AF>& from, const Address<AF>& to, std::span<const std::byte> data)
+  {
+    const auto it = m_bound_.find(to);
+
+    if(it == m_bound_.end() || m_endpoints_[it->second].stream)
+    {
+      ++m_dropped_;
+      return;
+    }
+
+    const std::uint32_t m = alloc_message();
+    m_messages_[m].data.assign(data.begin(), data.end());
+    m_messages_[m].from = from;
+
+    schedule(m, src, it->second, m_endpoints_[it->second].generation);
+  }
+
+  void send_stream(std::uint32_t src, std::span<const std::byte> data)
+  {
+    const endpoint& e = m_endpoints_[src];
+    const std::uint32_t m = alloc_message();
+    m_messages_[m].data.assign(data.begin(), data.end());
+
+    schedule(m, src, e.peer, e.peer_generation);
+  }
+
+  //creates server side of connection and queues it to listener, returns client endpoint or none if refused
+  std::uint32_t connect(const Address<AF>& to)
+  {
+    const auto it = m_bound_.find(to);
+    if(it == m_bound_.end()) return none;
+
+    const std::uint32_t listener = it->second;
+    if(!m_endpoints_[listener].listening || m_endpoints_[listener].backlog >= m_endpoints_[listener].max_backlog)
+      return none;
+
+    //endpoint vector may grow, so take references after both allocations
+    const std::uint32_t client = open_endpoint(true);
+    const std::uint32_t server = open_endpoint(true);
+    bind_ephemeral(client);
+
+    endpoint& c = m_endpoints_[client];
+    endpoint& s = m_endpoints_[server];
+
+    c.peer = server;
+    c.peer_generation = s.generation;
+    c.peer_addr = to;
+
+    s.peer = client;
+    s.peer_generation = c.generation;
+    s.peer_addr = c.addr;
+    s.addr = to;
+
+    ++m_endpoints_[listener].backlog;
+
+    const std::uint32_t m = alloc_message();
+    m_messages_[m].kind = message_kind::connect;
+    m_messages_[m].conn = server;
+    m_messages_[m].from = c.addr;
+
+    //handshake takes same time as data, so data sent right after connect arrives after connection is accepted
+    schedule(m, client, listener, m_endpoints_[listener].generation);
+
+    return client;
+  }
+
+  void deliver(std::uint32_t msg)
+  {
+    message& m = m_messages_[msg];
+    endpoint& e = m_endpoints_[m.dst];
+
+    const bool alive = e.open && e.generation == m.dst_generation;
+
+    //connected datagram socket filters other senders like connected udp socket
+    const bool filtered = !e.stream && e.peer_addr && m.from && *m.from != *e.peer_addr;
+
+    if(!alive || filtered)
+    {
+      const std::uint32_t conn = m.kind == message_kind::connect ? m.conn : none;
+
+      ++m_dropped_;
+      free_message(msg);
+
+      //closing allocates fin message, so message reference is not used after it
+      if(conn != none) close_endpoint(conn);
+
+      return;
+    }
+
+    ++m_delivered_;
+
+    if(m.kind == message_kind::fin)
+    {
+      e.peer_closed = true;
+      free_message(msg);
+      return;
+    }
+
+    if(e.stream) e.available += m.data.size();
+
+    if(e.inbox_tail == none)
+      e.inbox_head = msg;
+    else
+      m_messages_[e.inbox_tail].next = msg;
+
+    e.inbox_tail = msg;
+  }
+
+  //stream read of exactly size bytes, false if not enough data arrived yet
+  bool read_stream(std::uint32_t id, void* buffer, std::size_t size)
+  {
+    endpoint& e = m_endpoints_[id];
+
+    if(e.available < size) return false;
+
+    auto* out = static_cast<std::byte*>(buffer);
+
+    while(size != 0)
+    {
+      const message& m = m_messages_[e.inbox_head];
+      const std::size_t n = (std::min)(size, m.data.size() - e.head_offset);
+
+      std::memcpy(out, m.data.data() + e.head_offset, n);
+      out += n;
+      size -= n;
+      e.available -= n;
+      e.head_offset += n;
+
+      if(e.head_offset == m.data.size()) free_message(inbox_pop(id));
+    }
+
+    return true;
+  }
+
+  bool readable(std::uint32_t id) const noexcept
+  {
+    const endpoint& e = m_endpoints_[id];
+
+    return e.inbox_head != none || (e.stream && e.peer_closed);
+  }
+
+  //runs network until endpoint becomes readable or timeout in virtual milliseconds expires (-1 for no timeout)
+  bool wait_readable(std::uint32_t id, int timeout_ms)
+  {
+    const std::uint64_t deadline =
+      timeout_ms < 0 ? (std::numeric_limits<std::uint64_t>::max)() : m_now_ + std::uint64_t(timeout_ms) * 1000000;
+
+    while(!readable(id))
+    {
+      if(m_events_.empty() || m_events_.top().time > deadline)
+      {
+        if(timeout_ms >= 0) m_now_ = (std::max)(m_now_, deadline);
+        break;
+      }
+
+      step();
+    }
+
+    return readable(id);
+  }
+
+public:
+  explicit LoopbackNetwork(const LoopbackSettings& settings = {}) :
+    m_settings_(settings), m_rng_(settings.seed) {}
+
+  //sockets refer to network by pointer
+  LoopbackNetwork(const LoopbackNetwork&) = delete;
+  LoopbackNetwork& operator=(const LoopbackNetwork&) = delete;
+
+  const LoopbackSettings& settings() const noexcept { return m_settings_; }
+  void set_settings(const LoopbackSettings& settings) noexcept { m_settings_ = settings; }
+
+  //virtual time in nanoseconds
+  std::uint64_t now() const noexcept { return m_now_; }
+
+  std::size_t in_flight() const noexcept { return m_events_.size(); }
+  std::uint64_t delivered() const noexcept { return m_delivered_; }
+  std::uint64_t dropped() const noexcept { return m_dropped_; }
+
+  //delivers all messages due at nearest delivery time and moves clock there,
+  //returns false if nothing is in flight
+  bool step()
+  {
+    if(m_events_.empty()) return false;
+
+    m_now_ = (std::max)(m_now_, m_events_.top().time);
+
+    while(!m_events_.empty() && m_events_.top().time <= m_now_)
+    {
+      const std::uint32_t msg = m_events_.top().msg;
+      m_events_.pop();
+      deliver(msg);
+    }
+
+    return true;
+  }
+
+  //moves clock forward delivering messages due meanwhile, returns number of delivered messages
+  std::size_t advance(std::uint64_t ns)
+  {
+    const std::uint64_t delivered = m_delivered_;
+    const std::uint64_t until = m_now_ + ns;
+
+    while(!m_events_.empty() && m_events_.top().time <= until) step();
+
+    m_now_ = until;
+
+    return m_delivered_ - delivered;
+  }
+
+  //runs until nothing is in flight
+  std::size_t run()
+  {
+    const std::uint64_t delivered = m_delivered_;
+
+    while(step());
+
+    return m_delivered_ - delivered;
+  }
+
+  //raw datagram path through link model, e.g. for replaying captured traffic
+  void inject(const Address<AF>& from, const Address<AF>& to, std::span<const std::byte> data)
+  {
+    //injected datagram uses link model of datagram socket, sender endpoint is temporary
+    const std::uint32_t src = open_endpoint(false);
+    send_datagram(src, from, to, data);
+    close_endpoint(src);
+  }
+
+  template<SocketInfo SI, ConnectionSettings SCS = default_connection_settings, auto EHP = ehl::Policy::Exception>
+    requires (SI.address_family == AF)
+  [[nodiscard]] ehl::Result_t<LoopbackSocket<SI, inv_connect, SCS>, sys_errc::ErrorCode, EHP>
+  client_socket(const Address<AF>& dest_addr) noexcept(EHP != ehl::Policy::Exception)
+  {
+    if constexpr(SI.type == SocketType::Datagram)
+    {
+      const std::uint32_t id = open_endpoint(false);
+      bind_ephemeral(id);
+      m_endpoints_[id].peer_addr = dest_addr;
+
+      return LoopbackSocket<SI, inv_connect, SCS>(this, id);
+    }
+    else
+    {
+      const std::uint32_t id = connect(dest_addr);
+
+      EHL_THROW_IF(id == none, sys_errc::ErrorCode(sys_errc::common::sockets::not_connected));
+
+      return LoopbackSocket<SI, inv_connect, SCS>(this, id);
+    }
+  }
+
+  template<SocketInfo SI, ConnectionSettings SCS = default_connection_settings, auto EHP = ehl::Policy::Exception>
+    requires (SI.address_family == AF && SI.type == SocketType::Datagram)
+  [[nodiscard]] ehl::Result_t<LoopbackSocket<SI, inv_bind_connect, SCS>, sys_errc::ErrorCode, EHP>
+  client_socket(const Address<AF>& bind_addr, const Address<AF>& dest_addr) noexcept(EHP != ehl::Policy::Exception)
+  {
+    const std::uint32_t id = open_endpoint(false);
+
+    if(!bind(id, bind_addr)) close_endpoint(id);
+
+    EHL_THROW_IF(!m_endpoints_[id].open, sys_errc::ErrorCode(sys_errc::common::sockets::invalid_argument));
+
+    m_endpoints_[id].peer_addr = dest_addr;
+
+    return LoopbackSocket<SI, inv_bind_connect, SCS>(this, id);
+  }
+
+  template<SocketInfo SI, auto EHP = ehl::Policy::Exception>
+    requires (SI.address_family == AF && SI.type == SocketType::Datagram)
+  [[nodiscard]] ehl::Result_t<LoopbackSocket<SI, inv_bind, default_connection_settings>, sys_errc::ErrorCode, EHP>
+  server_socket(const Address<AF>& bind_addr) noexcept(EHP != ehl::Policy::Exception)
+  {
+    const std::uint32_t id = open_endpoint(false);
+
+    if(!bind(id, bind_addr)) close_endpoint(id);
+
+    EHL_THROW_IF(!m_endpoints_[id].open, sys_errc::ErrorCode(sys_errc::common::sockets::invalid_argument));
+
+    return LoopbackSocket<SI, inv_bind, default_connection_settings>(this, id);
+  }
+
+  template<SocketInfo SI, auto EHP = ehl::Policy::Exception>
+    requires (SI.address_family == AF && SI.type != SocketType::Datagram)
+  [[nodiscard]] ehl::Result_t<LoopbackSocket<SI, inv_bind_listen, default_connection_settings>, sys_errc::ErrorCode, EHP>
+  server_socket(const Address<AF>& bind_addr, unsigned max_connections) noexcept(EHP != ehl::Policy::Exception)
+  {
+    const std::uint32_t id = open_endpoint(true);
+
+    if(!bind(id, bind_addr)) close_endpoint(id);
+
+    EHL_THROW_IF(!m_endpoints_[id].open, sys_errc::ErrorCode(sys_errc::common::sockets::invalid_argument));
+
+    m_endpoints_[id].listening = true;
+    m_endpoints_[id].max_backlog = max_connections;
+
+    return LoopbackSocket<SI, inv_bind_listen, default_connection_settings>(this, id);
+  }
+};
+
+//Simulated counterpart of Socket, created by LoopbackNetwork.
+//SeqPacket connections are simulated as streams.
+template<SocketInfo SI, InvInfo INV, ConnectionSettings SCS>
+class LoopbackSocket
+{
+  static_assert(SCS.encoding == WireEncoding::Raw, "only raw wire encoding is supported");
+  static_assert(!SCS.negotiate_byte_order, "loopback peers share byte order, use local_connection_settings");
+
+  using network_type = LoopbackNetwork<SI.address_family>;
+
+  friend network_type;
+
+  template<SocketInfo, InvInfo, ConnectionSettings>
+  friend class LoopbackSocket;
+
+  network_type* m_net_;
+  std::uint32_t m_id_;
+
+  LoopbackSocket(network_type* net, std::uint32_t id) noexcept : m_net_(net), m_id_(id) {}
+
+  static constexpr bool is_stream = SI.type != SocketType::Datagram;
+
+  template<ConnectionSettings CS, packet_type T>
+  static constexpr T convert_byte_order(T t) noexcept
+  {
+    if constexpr(CS.convert_byte_order)
+      details::convert_byte_order(t);
+
+    return t;
+  }
+
+  template<packet_type T>
+  static T load(std::span<const std::byte> data) noexcept
+  {
+    T t;
+    std::memcpy(&t, data.data(), sizeof(T));
+    return t;
+  }
+
+  //same rule as datagram socket: exactly one alternative must match size and be valid
+  template<ConnectionSettings CS, packet_variant_type V>
+  static std::optional<V> decode_variant(std::span<const std::byte> data) noexcept
+  {
+    const auto match = [&]<typename T>()
+    {
+      return data.size() == sizeof(T) && convert_byte_order<CS>(load<T>(data)).is_valid();
+    };
+
+    const auto v = [&]<std::size_t... Is>(std::index_sequence<Is...>)
+    {
+      return std::array{match.template operator()<std::variant_alternative_t<Is, V>>()...};
+    }(std::make_index_sequence<std::variant_size_v<V>>{});
+
+    if(std::ranges::count(v, true) != 1) return std::nullopt;
+
+    std::optional<V> res;
+    [&]<std::size_t... Is>(std::index_sequence<Is...>)
+    {
+      (void)((v[Is] && (res.emplace(std::in_place_index<Is>,
+        convert_byte_order<CS>(load<std::variant_alternative_t<Is, V>>(data))), true)) || ...);
+    }(std::make_index_sequence<std::variant_size_v<V>>{});
+
+    return res;
+  }
+
+  template<ConnectionSettings CS, packet_variant_type V>
+  static std::span<const std::byte> encode_variant(V& v) noexcept
+  {
+    return std::visit([](auto& p)
+    {
+      p = convert_byte_order<CS>(p);
+      return std::as_bytes(std::span{&p, 1});
+    }, v);
+  }
+
+  void send_bytes(std::span<const std::byte> data)
+  {
+    if constexpr(is_stream)
+      m_net_->send_stream(m_id_, data);
+    else
+      m_net_->send_datagram(m_id_, *endpoint().addr, *endpoint().peer_addr, data);
+  }
+
+  typename network_type::endpoint& endpoint() const noexcept { return m_net_->m_endpoints_[m_id_]; }
+
+  bool has_message() const noexcept { return endpoint().inbox_head != network_type::none; }
+
+  static constexpr sys_errc::ErrorCode not_connected_err         = sys_errc::common::sockets::not_connected;
+  static constexpr sys_errc::ErrorCode wrong_protocol_type_err   = sys_errc::common::sockets::wrong_protocol_type;
+  static constexpr sys_errc::ErrorCode invalid_argument_err      = sys_errc::common::sockets::invalid_argument;
+  static constexpr sys_errc::ErrorCode operation_would_block_err = sys_errc::common::sockets::operation_would_block;
+
+public:
+  static constexpr SocketInfo socket_info = SI;
+  static constexpr InvInfo inv_info = INV;
+  static constexpr ConnectionSettings connection_settings = SCS;
+
+  template<typename T>
+  using recvfrom_result = typename Socket<SI, INV, SCS>::template recvfrom_result<T>;
+
+  LoopbackSocket(LoopbackSocket&& s) noexcept :
+    m_net_(std::exchange(s.m_net_, nullptr)), m_id_(s.m_id_) {}
+
+  LoopbackSocket& operator=(LoopbackSocket&& s) noexcept
+  {
+    LoopbackSocket tmp(std::move(s));
+
+    std::swap(m_net_, tmp.m_net_);
+    std::swap(m_id_, tmp.m_id_);
+
+    return *this;
+  }
+
+  ~LoopbackSocket()
+  {
+    if(m_net_) m_net_->close_endpoint(m_id_);
+  }
+
+  const Address<SI.address_family>& address() const noexcept { return *endpoint().addr; }
+
+  template<ConnectionSettings CS = default_connection_settings, auto EHP = ehl::Policy::Exception>
+  [[nodiscard]] ehl::Result_t<LoopbackIncomingConnection<SI, inv_connect, CS>, sys_errc::ErrorCode, EHP> accept()
+    noexcept(EHP != ehl::Policy::Exception) requires (SI.type != SocketType::Datagram && INV.binded && INV.listening)
+  {
+    EHL_THROW_IF(!has_message(), operation_would_block_err);
+
+    const std::uint32_t m = m_net_->inbox_pop(m_id_);
+    const std::uint32_t conn = m_net_->m_messages_[m].conn;
+    const Address<SI.address_family> addr = *m_net_->m_messages_[m].from;
+
+    m_net_->free_message(m);
+    --endpoint().backlog;
+
+    return LoopbackIncomingConnection<SI, inv_connect, CS>{LoopbackSocket<SI, inv_connect, CS>(m_net_, conn), addr};
+  }
+
+  template<packet_type T, auto EHP = ehl::Policy::Exception> requires (INV.connected)
+  [[nodiscard]] ehl::Result_t<valid_packet<T>, sys_errc::ErrorCode, EHP> recv() noexcept(EHP != ehl::Policy::Exception)
+  {
+    T t;
+
+    if constexpr(is_stream)
+    {
+      EHL_THROW_IF(
+        !m_net_->read_stream(m_id_, &t, sizeof(T)),
+        endpoint().peer_closed ? not_connected_err : operation_would_block_err);
+    }
+    else
+    {
+      EHL_THROW_IF(!has_message(), operation_would_block_err);
+
+      const std::uint32_t m = m_net_->inbox_pop(m_id_);
+      const std::span<const std::byte> data = m_net_->m_messages_[m].data;
+      const bool size_matches = data.size() == sizeof(T);
+
+      if(size_matches) t = load<T>(data);
+      m_net_->free_message(m);
+
+      EHL_THROW_IF(!size_matches, wrong_protocol_type_err);
+    }
+
+    T result = convert_byte_order<SCS>(t);
+
+    EHL_THROW_IF(!result.is_valid(), wrong_protocol_type_err);
+
+    return std::bit_cast<valid_packet<T>>(result);
+  }
+
+  template<packet_variant_type V, auto EHP = ehl::Policy::Exception>
+    requires (INV.connected && SI.type != SocketType::Stream)
+  [[nodiscard]] ehl::Result_t<valid_packet_variant<V>, sys_errc::ErrorCode, EHP> recv() noexcept(EHP != ehl::Policy::Exception)
+  {
+    EHL_THROW_IF(!has_message(), is_stream && endpoint().peer_closed ? not_connected_err : operation_would_block_err);
+
+    //seqpacket keeps message boundaries, each send is one message
+    const std::uint32_t m = m_net_->inbox_pop(m_id_);
+    if constexpr(is_stream) endpoint().available -= m_net_->m_messages_[m].data.size();
+
+    std::optional<V> res = decode_variant<SCS, V>(m_net_->m_messages_[m].data);
+    m_net_->free_message(m);
+
+    EHL_THROW_IF(!res, wrong_protocol_type_err);
+
+    return std::bit_cast<valid_packet_variant<V>>(*res);
+  }
+
+  template<auto EHP = ehl::Policy::Exception, packet_type T> requires (INV.connected)
+  [[nodiscard]] ehl::Result_t<void, sys_errc::ErrorCode, EHP> send(const valid_packet<T>& t)
+    noexcept(EHP != ehl::Policy::Exception)
+  {
+    EHL_THROW_IF(is_stream && endpoint().peer_closed, not_connected_err);
+
+    T t_copy = convert_byte_order<SCS, T>(t);
+
+    send_bytes(std::as_bytes(std::span{&t_copy, 1}));
+  }
+
+  template<auto EHP = ehl::Policy::Exception, packet_type T> requires (INV.connected)
+  [[nodiscard]] ehl::Result_t<void, sys_errc::ErrorCode, EHP> send(const T& t)
+    noexcept(EHP != ehl::Policy::Exception)
+  {
+    EHL_THROW_IF(!t.is_valid(), invalid_argument_err);
+
+    return send<EHP, T>(std::bit_cast<valid_packet<T>>(t));
+  }
+
+  template<auto EHP = ehl::Policy::Exception, packet_variant_type V> requires (INV.connected && SI.type != SocketType::Stream)
+  [[nodiscard]] ehl::Result_t<void, sys_errc::ErrorCode, EHP> send(const valid_packet_variant<V>& v)
+    noexcept(EHP != ehl::Policy::Exception)
+  {
+    EHL_THROW_IF(is_stream && endpoint().peer_closed, not_connected_err);
+
+    V v_copy = v;
+
+    send_bytes(encode_variant<SCS>(v_copy));
+  }
+
+  template<auto EHP = ehl::Policy::Exception, packet_variant_type V> requires (INV.connected && SI.type != SocketType::Stream)
+  [[nodiscard]] ehl::Result_t<void, sys_errc::ErrorCode, EHP> send(const V& v)
+    noexcept(EHP != ehl::Policy::Exception)
+  {
+    EHL_THROW_IF(!packet_variant_validate_predicate<V>(v), invalid_argument_err);
+
+    return send<EHP, V>(std::bit_cast<valid_packet_variant<V>>(v));
+  }
+
+  template<packet_type T, ConnectionSettings CS = default_connection_settings, auto EHP = ehl::Policy::Exception>
+    requires (SI.type == SocketType::Datagram)
+  [[nodiscard]] ehl::Result_t<recvfrom_result<T>, sys_errc::ErrorCode, EHP> recvfrom()
+    noexcept(EHP != ehl::Policy::Exception)
+  {
+    EHL_THROW_IF(!has_message(), operation_would_block_err);
+
+    const std::uint32_t m = m_net_->inbox_pop(m_id_);
+    const std::span<const std::byte> data = m_net_->m_messages_[m].data;
+    const bool size_matches = data.size() == sizeof(T);
+    const Address<SI.address_family> addr = *m_net_->m_messages_[m].from;
+
+    T t;
+    if(size_matches) t = load<T>(data);
+    m_net_->free_message(m);
+
+    EHL_THROW_IF(!size_matches, wrong_protocol_type_err);
+
+    T result = convert_byte_order<CS, T>(t);
+
+    EHL_THROW_IF(!result.is_valid(), invalid_argument_err);
+
+    return recvfrom_result<T>{std::bit_cast<valid_packet<T>>(result), addr};
+  }
+
+  template<packet_variant_type V, ConnectionSettings CS = default_connection_settings, auto EHP = ehl::Policy::Exception>
+    requires (SI.type == SocketType::Datagram)
+  [[nodiscard]] ehl::Result_t<recvfrom_result<V>, sys_errc::ErrorCode, EHP> recvfrom()
+    noexcept(EHP != ehl::Policy::Exception)
+  {
+    EHL_THROW_IF(!has_message(), operation_would_block_err);
+
+    const std::uint32_t m = m_net_->inbox_pop(m_id_);
+    const Address<SI.address_family> addr = *m_net_->m_messages_[m].from;
+
+    std::optional<V> res = decode_variant<CS, V>(m_net_->m_messages_[m].data);
+    m_net_->free_message(m);
+
+    EHL_THROW_IF(!res, wrong_protocol_type_err);
+
+    return recvfrom_result<V>{std::bit_cast<valid_packet_variant<V>>(*res), addr};
+  }
+
+  template<ConnectionSettings CS = default_connection_settings, auto EHP = ehl::Policy::Exception, packet_type T>
+    requires (SI.type == SocketType::Datagram)
+  [[nodiscard]] ehl::Result_t<void, sys_errc::ErrorCode, EHP> sendto(
+    const valid_packet<T>& t, const Address<SI.address_family>& addr)
+      noexcept(EHP != ehl::Policy::Exception)
+  {
+    T t_copy = convert_byte_order<CS, T>(t);
+
+    m_net_->send_datagram(m_id_, address(), addr, std::as_bytes(std::span{&t_copy, 1}));
+  }
+
+  template<ConnectionSettings CS = default_connection_settings, auto EHP = ehl::Policy::Exception, packet_type T>
+    requires (SI.type == SocketType::Datagram)
+  [[nodiscard]] ehl::Result_t<void, sys_errc::ErrorCode, EHP> sendto(const T& t, const Address<SI.address_family>& addr)
+      noexcept(EHP != ehl::Policy::Exception)
+  {
+    EHL_THROW_IF(!t.is_valid(), invalid_argument_err);
+
+    return sendto<CS, EHP, T>(std::bit_cast<valid_packet<T>>(t), addr);
+  }
+
+  template<ConnectionSettings CS = default_connection_settings, auto EHP = ehl::Policy::Exception, packet_variant_type V>
+    requires (SI.type == SocketType::Datagram)
+  [[nodiscard]] ehl::Result_t<void, sys_errc::ErrorCode, EHP> sendto(
+    const valid_packet_variant<V>& v, const Address<SI.address_family>& addr)
+      noexcept(EHP != ehl::Policy::Exception)
+  {
+    V v_copy = v;
+
+    m_net_->send_datagram(m_id_, address(), addr, encode_variant<CS>(v_copy));
+  }
+
+  template<ConnectionSettings CS = default_connection_settings, auto EHP = ehl::Policy::Exception, packet_variant_type V>
+    requires (SI.type == SocketType::Datagram)
+  [[nodiscard]] ehl::Result_t<void, sys_errc::ErrorCode, EHP> sendto(
+    const V& v, const Address<SI.address_family>& addr)
+      noexcept(EHP != ehl::Policy::Exception)
+  {
+    EHL_THROW_IF(!packet_variant_validate_predicate<V>(v), invalid_argument_err);
+
+    return sendto<CS, EHP, V>(std::bit_cast<valid_packet_variant<V>>(v), addr);
+  }
+
+  //timeout is in virtual milliseconds, waiting runs network forward
+  template<PollFlags PF, auto EHP = ehl::Policy::Exception>
+  [[nodiscard]] ehl::Result_t<bool, sys_errc::ErrorCode, EHP> poll(int timeout_ms) noexcept(EHP != ehl::Policy::Exception)
+  {
+    if constexpr(PF == PollFlags::Out)
+      return true;
+    else
+      return m_net_->wait_readable(m_id_, timeout_ms);
+  }
+
+  //fails with operation_would_block if nothing in flight can make socket readable
+  template<PollFlags PF, auto EHP = ehl::Policy::Exception>
+  [[nodiscard]] ehl::Result_t<void, sys_errc::ErrorCode, EHP> poll() noexcept(EHP != ehl::Policy::Exception)
+  {
+    if constexpr(PF == PollFlags::In)
+      EHL_THROW_IF(!m_net_->wait_readable(m_id_, -1), operation_would_block_err);
+  }
+};
+
+} //namespace cpps
@@ -0,0 +1,243 @@
+#pragma once
+
+#include "details/platform_headers.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <limits>
+#include "socket.hpp"
+#include "details/socket_access.hpp"
+
+#if HPP_POSIX_IMPL
+  #include <net/if.h>
+  #include <netinet/in.h>
+#endif
+
+namespace cpps
+{
+
+namespace details
+{
+
+template<SocketInfo SI>
+constexpr bool multicast_capable = SI.type == SocketType::Datagram && SI.address_family != AddressFamily::Unix;
+
+template<AddressFamily AF>
+constexpr int multicast_level = AF == AddressFamily::IPv4 ? IPPROTO_IP : IPPROTO_IPV6;
+
+//IPv4 multicast TTL and loop options are byte sized on BSD and macOS
+#if HPP_WIN_IMPL || defined(__linux__)
+using ipv4_multicast_option = int;
+#else
+using ipv4_multicast_option = unsigned char;
+#endif
+
+template<typename T>
+int set_option(socket_resource::Handle h, int level, int name, const T& value) noexcept
+{
+  return ::setsockopt(h, level, name, reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template<AddressFamily AF>
+sockaddr_storage to_sockaddr_storage(const Address<AF>& addr) noexcept
+{
+  sockaddr_storage s{};
+  std::memcpy(&s, to_sockaddr_ptr(&addr), sizeof(addr));
+
+  return s;
+}
+
+//protocol independent membership requests (RFC 3678), same for IPv4 and IPv6
+template<AddressFamily AF>
+int change_membership(socket_resource::Handle h, int option, const Address<AF>& group, unsigned interface_index) noexcept
+{
+  group_req req{};
+  req.gr_interface = interface_index;
+  req.gr_group     = to_sockaddr_storage(group);
+
+  return set_option(h, multicast_level<AF>, option, req);
+}
+
+template<AddressFamily AF>
+int change_source_membership(
+  socket_resource::Handle h, int option, const Address<AF>& group, const Address<AF>& source, unsigned interface_index)
+    noexcept
+{
+  group_source_req req{};
+  req.gsr_interface = interface_index;
+  req.gsr_group     = to_sockaddr_storage(group);
+  req.gsr_source    = to_sockaddr_storage(source);
+
+  return set_option(h, multicast_level<AF>, option, req);
+}
+
+} //namespace details
+
+//Index of network interface by name (e.g. "eth0") for multicast functions, 0 means system choice
+template<auto EHP = ehl::Policy::Exception>
+[[nodiscard]] ehl::Result_t<unsigned, sys_errc::ErrorCode, EHP> interface_index(const char* name)
+  noexcept(EHP != ehl::Policy::Exception)
+{
+  unsigned index = ::if_nametoindex(name);
+
+  EHL_THROW_IF(index == 0, sys_errc::ErrorCode(sys_errc::common::sockets::invalid_argument));
+
+  return index;
+}
+
+//Joins any-source multicast group on interface, 0 lets system choose it by routing table.
+//Port of group address is ignored, socket receives datagrams sent to port it is bound to
+template<auto EHP = ehl::Policy::Exception, SocketInfo SI, InvInfo INV, ConnectionSettings SCS>
+  requires (details::multicast_capable<SI>)
+[[nodiscard]] ehl::Result_t<void, sys_errc::ErrorCode, EHP> join_group(
+  Socket<SI, INV, SCS>& sock, const Address<SI.address_family>& group, unsigned interface_index = 0)
+    noexcept(EHP != ehl::Policy::Exception)
+{
+  int r = details::change_membership(details::socket_access::handle(sock), MCAST_JOIN_GROUP, group, interface_index);
+
+  EHL_THROW_IF(r != 0, sys_errc::last_error());
+}
+
+template<auto EHP = ehl::Policy::Exception, SocketInfo SI, InvInfo INV, ConnectionSettings SCS>
+  requires (details::multicast_capable<SI>)
+[[nodiscard]] ehl::Result_t<void, sys_errc::ErrorCode, EHP> leave_group(
+  Socket<SI, INV, SCS>& sock, const Address<SI.address_family>& group, unsigned interface_index = 0)
+    noexcept(EHP != ehl::Policy::Exception)
+{
+  int r = details::change_membership(details::socket_access::handle(sock), MCAST_LEAVE_GROUP, group, interface_index);
+
+  EHL_THROW_IF(r != 0, sys_errc::last_error());
+}
+
+//Joins source-specific multicast group (SSM), only datagrams of source are received
+template<auto EHP = ehl::Policy::Exception, SocketInfo SI, InvInfo INV, ConnectionSettings SCS>
+  requires (details::multicast_capable<SI>)
+[[nodiscard]] ehl::Result_t<void, sys_errc::ErrorCode, EHP> join_source_group(
+  Socket<SI, INV, SCS>& sock,
+  const Address<SI.address_family>& group,
+  const Address<SI.address_family>& source,
+  unsigned interface_index = 0)
+    noexcept(EHP != ehl::Policy::Exception)
+{
+  int r = details::change_source_membership(
+    details::socket_access::handle(sock), MCAST_JOIN_SOURCE_GROUP, group, source, interface_index);
+
+  EHL_THROW_IF(r != 0, sys_errc::last_error());
+}
+
+template<auto EHP = ehl::Policy::Exception, SocketInfo SI, InvInfo INV, ConnectionSettings SCS>
+  requires (details::multicast_capable<SI>)
+[[nodiscard]] ehl::Result_t<void, sys_errc::ErrorCode, EHP> leave_source_group(
+  Socket<SI, INV, SCS>& sock,
+  const Address<SI.address_family>& group,
+  const Address<SI.address_family>& source,
+  unsigned interface_index = 0)
+    noexcept(EHP != ehl::Policy::Exception)
+{
+  int r = details::change_source_membership(
+    details::socket_access::handle(sock), MCAST_LEAVE_SOURCE_GROUP, group, source, interface_index);
+
+  EHL_THROW_IF(r != 0, sys_errc::last_error());
+}
+
+//Hops limit of sent multicast datagrams, default 1 keeps them in local network
+template<auto EHP = ehl::Policy::Exception, SocketInfo SI, InvInfo INV, ConnectionSettings SCS>
+  requires (details::multicast_capable<SI>)
+[[nodiscard]] ehl::Result_t<void, sys_errc::ErrorCode, EHP> set_multicast_ttl(Socket<SI, INV, SCS>& sock, unsigned ttl)
+  noexcept(EHP != ehl::Policy::Exception)
+{
+  EHL_THROW_IF(ttl > 255, sys_errc::ErrorCode(sys_errc::common::sockets::invalid_argument));
+
+  const auto h = details::socket_access::handle(sock);
+
+  int r;
+  if constexpr(SI.address_family == AddressFamily::IPv4)
+    r = details::set_option(h, IPPROTO_IP, IP_MULTICAST_TTL, static_cast<details::ipv4_multicast_option>(ttl));
+  else
+    r = details::set_option(h, IPPROTO_IPV6, IPV6_MULTICAST_HOPS, static_cast<int>(ttl));
+
+  EHL_THROW_IF(r != 0, sys_errc::last_error());
+}
+
+//Whether sent multicast datagrams are delivered to members on same host, enabled by default
+template<auto EHP = ehl::Policy::Exception, SocketInfo SI, InvInfo INV, ConnectionSettings SCS>
+  requires (details::multicast_capable<SI>)
+[[nodiscard]] ehl::Result_t<void, sys_errc::ErrorCode, EHP> set_multicast_loop(Socket<SI, INV, SCS>& sock, bool loop)
+  noexcept(EHP != ehl::Policy::Exception)
+{
+  const auto h = details::socket_access::handle(sock);
+
+  int r;
+  if constexpr(SI.address_family == AddressFamily::IPv4)
+    r = details::set_option(h, IPPROTO_IP, IP_MULTICAST_LOOP, static_cast<details::ipv4_multicast_option>(loop));
+  else
+    r = details::set_option(h, IPPROTO_IPV6, IPV6_MULTICAST_LOOP, static_cast<unsigned>(loop));
+
+  EHL_THROW_IF(r != 0, sys_errc::last_error());
+}
+
+//Interface for sent multicast datagrams, 0 lets system choose it by routing table
+template<auto EHP = ehl::Policy::Exception, SocketInfo SI, InvInfo INV, ConnectionSettings SCS>
+  requires (details::multicast_capable<SI>)
+[[nodiscard]] ehl::Result_t<void, sys_errc::ErrorCode, EHP> set_multicast_interface(
+  Socket<SI, INV, SCS>& sock, unsigned interface_index)
+    noexcept(EHP != ehl::Policy::Exception)
+{
+  const auto h = details::socket_access::handle(sock);
+
+  int r;
+  if constexpr(SI.address_family == AddressFamily::IPv4)
+  {
+#if HPP_WIN_IMPL
+    //index is passed as address 0.0.0.index
+    r = details::set_option(h, IPPROTO_IP, IP_MULTICAST_IF, ::htonl(interface_index));
+#elif defined(IP_MULTICAST_IFINDEX)
+    r = details::set_option(h, IPPROTO_IP, IP_MULTICAST_IFINDEX, interface_index);
+#else
+    ip_mreqn req{};
+    req.imr_ifindex = static_cast<int>(interface_index);
+
+    r = details::set_option(h, IPPROTO_IP, IP_MULTICAST_IF, req);
+#endif
+  }
+  else
+    r = details::set_option(h, IPPROTO_IPV6, IPV6_MULTICAST_IF, interface_index);
+
+  EHL_THROW_IF(r != 0, sys_errc::last_error());
+}
+
+//Enlarges kernel receive buffer so bursts are queued instead of dropped while receiver catches up.
+//On Linux limit of net.core.rmem_max is bypassed when process has CAP_NET_ADMIN.
+//Returns size granted by kernel, which may be smaller (limit) or bigger (Linux counts bookkeeping)
+template<auto EHP = ehl::Policy::Exception, SocketInfo SI, InvInfo INV, ConnectionSettings SCS>
+[[nodiscard]] ehl::Result_t<std::size_t, sys_errc::ErrorCode, EHP> set_receive_buffer(
+  Socket<SI, INV, SCS>& sock, std::size_t size)
+    noexcept(EHP != ehl::Policy::Exception)
+{
+  const auto h = details::socket_access::handle(sock);
+  const int requested = static_cast<int>((std::min)(size, static_cast<std::size_t>(std::numeric_limits<int>::max() / 2)));
+
+  int r = -1;
+
+#if defined(SO_RCVBUFFORCE)
+  r = details::set_option(h, SOL_SOCKET, SO_RCVBUFFORCE, requested);
+#endif
+
+  //without privilege kernel clamps size to limit
+  if(r != 0)
+    r = details::set_option(h, SOL_SOCKET, SO_RCVBUF, requested);
+
+  EHL_THROW_IF(r != 0, sys_errc::last_error());
+
+  int granted = 0;
+  details::socklen_type len = sizeof(granted);
+
+  r = ::getsockopt(h, SOL_SOCKET, SO_RCVBUF, reinterpret_cast<char*>(&granted), &len);
+
+  EHL_THROW_IF(r != 0, sys_errc::last_error());
+
+  return static_cast<std::size_t>(granted);
+}
+
+} //namespace cpps
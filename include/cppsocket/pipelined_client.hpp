@@ -0,0 +1,358 @@
+#pragma once
+
+#include <chrono>
+#include <concepts>
+#include <cstring>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+#include "socket.hpp"
+#include "details/batch_io.hpp"
+#include "details/nonblocking.hpp"
+#include "details/socket_access.hpp"
+
+namespace cpps
+{
+
+namespace details
+{
+
+template<typename M>
+struct member_pointer_traits;
+
+template<typename C, typename M>
+struct member_pointer_traits<M C::*>
+{
+  using class_type = C;
+  using member_type = M;
+};
+
+template<typename T>
+constexpr auto correlation_key(const T& t) noexcept
+{
+  if constexpr(fixed_t_type<T>)
+    return t.underlying_value();
+  else
+    return t;
+}
+
+} //namespace details
+
+struct PipelineSettings
+{
+  //request without reply is reported to on_timeout after this time, unless other timeout is passed to send
+  std::chrono::milliseconds timeout = std::chrono::seconds(1);
+
+  //datagram request without reply is sent again after this time, at most max_retransmits times
+  std::chrono::milliseconds retransmit_interval = std::chrono::milliseconds(200);
+  unsigned max_retransmits = 3;
+
+  //send fails with no_buffer_space when this many requests wait for reply
+  std::size_t max_in_flight = 1024;
+};
+
+//Request/response client keeping many requests in flight on one connected socket.
+//Reply is matched to request by correlation fields ReqId/RepId (member pointers of integral or fixed_t type),
+//so replies may come in any order. Requests are sent by send, replies and timeouts are delivered by process.
+//Lost datagram requests are retransmitted, replies to already completed requests are ignored.
+//Not thread safe, socket must outlive client and must not be used directly meanwhile.
+template<SocketInfo SI, InvInfo INV, ConnectionSettings SCS, auto ReqId, auto RepId>
+  requires (INV.connected)
+class PipelinedClient
+{
+  static_assert(raw_unchecked_settings<SCS>, "only raw wire encoding without checksum is supported");
+
+public:
+  using request_type = typename details::member_pointer_traits<decltype(ReqId)>::class_type;
+  using reply_type = typename details::member_pointer_traits<decltype(RepId)>::class_type;
+
+  static_assert(packet_type<request_type> && packet_type<reply_type>);
+
+private:
+  using key_type = decltype(details::correlation_key(std::declval<request_type>().*ReqId));
+  using clock = std::chrono::steady_clock;
+
+  static_assert(std::integral<key_type>);
+  static_assert(std::same_as<key_type, decltype(details::correlation_key(std::declval<reply_type>().*RepId))>);
+
+  struct pending_request
+  {
+    request_type req;
+    clock::time_point deadline;
+    clock::time_point retransmit_at;
+    unsigned retransmits;
+  };
+
+  //stream replies are read in chunks, partial reply stays in buffer
+  static constexpr std::size_t rx_capacity = sizeof(reply_type) * 64;
+
+  static constexpr sys_errc::ErrorCode not_connected_err       = sys_errc::common::sockets::not_connected;
+  static constexpr sys_errc::ErrorCode wrong_protocol_type_err = sys_errc::common::sockets::wrong_protocol_type;
+  static constexpr sys_errc::ErrorCode invalid_argument_err    = sys_errc::common::sockets::invalid_argument;
+  static constexpr sys_errc::ErrorCode no_buffer_space_err     = sys_errc::common::sockets::no_buffer_space;
+
+  Socket<SI, INV, SCS>& m_sock_;
+  PipelineSettings m_settings_;
+  std::unordered_map<key_type, pending_request> m_pending_;
+  std::vector<std::byte> m_rx_;
+  std::size_t m_rx_size_ = 0;
+
+  bool write(const request_type& req) noexcept
+  {
+    request_type t = req;
+    if(m_sock_.converts_byte_order())
+      details::convert_byte_order(t);
+
+    const auto h = details::socket_access::handle(m_sock_);
+
+    if constexpr(SI.type == SocketType::Stream)
+    {
+      const details::const_buffer buf{&t, sizeof(t)};
+      return details::send_all(h, &buf, 1);
+    }
+    else
+    {
+      //refusal reported for earlier datagram while server is not bound yet, request counts as lost
+      return ::send(h, reinterpret_cast<const char*>(&t), sizeof(t), 0) == sizeof(t) || details::last_error_refused();
+    }
+  }
+
+  //converts and validates received reply, returns false for invalid one
+  bool decode(const std::byte* data, reply_type& rep) const noexcept
+  {
+    std::memcpy(&rep, data, sizeof(rep));
+    if(m_sock_.converts_byte_order())
+      details::convert_byte_order(rep);
+
+    return rep.is_valid();
+  }
+
+  template<typename OnReply>
+  bool complete(const reply_type& rep, OnReply& on_reply)
+  {
+    auto it = m_pending_.find(details::correlation_key(rep.*RepId));
+
+    //reply to retransmitted or timed out request
+    if(it == m_pending_.end()) return false;
+
+    const request_type req = it->second.req;
+    m_pending_.erase(it);
+
+    on_reply(req, std::bit_cast<valid_packet<reply_type>>(rep));
+
+    return true;
+  }
+
+  //reads available replies, returns number of completed requests or -1 with error in err
+  template<typename OnReply>
+  std::ptrdiff_t read_replies(OnReply& on_reply, sys_errc::ErrorCode& err)
+  {
+    const auto h = details::socket_access::handle(m_sock_);
+    std::ptrdiff_t done = 0;
+
+    if constexpr(SI.type == SocketType::Stream)
+    {
+      auto r = ::recv(h, reinterpret_cast<char*>(m_rx_.data() + m_rx_size_), static_cast<int>(rx_capacity - m_rx_size_), 0);
+
+      if(r <= 0)
+      {
+        err = r < 0 ? sys_errc::last_error() : not_connected_err;
+        return -1;
+      }
+
+      m_rx_size_ += static_cast<std::size_t>(r);
+
+      std::size_t offset = 0;
+      for(; m_rx_size_ - offset >= sizeof(reply_type); offset += sizeof(reply_type))
+      {
+        reply_type rep;
+
+        //stream can`t be resynchronized after invalid reply
+        if(!decode(m_rx_.data() + offset, rep))
+        {
+          err = wrong_protocol_type_err;
+          return -1;
+        }
+
+        done += complete(rep, on_reply);
+      }
+
+      std::memmove(m_rx_.data(), m_rx_.data() + offset, m_rx_size_ - offset);
+      m_rx_size_ -= offset;
+    }
+    else
+    {
+      //extra byte detects oversized datagram
+      std::byte buf[sizeof(reply_type) + 1];
+
+      auto r = ::recv(h, reinterpret_cast<char*>(buf), sizeof(buf), 0);
+
+      //refusal of earlier request is reported on receive, it was lost
+      if(r < 0 && details::last_error_refused()) return 0;
+
+      if(r < 0)
+      {
+        err = sys_errc::last_error();
+        return -1;
+      }
+
+      //datagrams of wrong size or invalid content are dropped like lost ones
+      reply_type rep;
+      if(r == sizeof(reply_type) && decode(buf, rep)) done += complete(rep, on_reply);
+    }
+
+    return done;
+  }
+
+  //handles expired and retransmits due requests, returns time of next timer
+  template<typename OnTimeout>
+  clock::time_point run_timers(clock::time_point now, OnTimeout& on_timeout, std::size_t& done)
+  {
+    auto next = clock::time_point::max();
+
+    for(auto it = m_pending_.begin(); it != m_pending_.end();)
+    {
+      auto& p = it->second;
+
+      if(now >= p.deadline)
+      {
+        const request_type req = p.req;
+        it = m_pending_.erase(it);
+        ++done;
+
+        on_timeout(req);
+        continue;
+      }
+
+      if constexpr(SI.type != SocketType::Stream)
+      {
+        //failed retransmit is same as lost one
+        if(p.retransmits < m_settings_.max_retransmits && now >= p.retransmit_at)
+        {
+          write(p.req);
+          ++p.retransmits;
+          p.retransmit_at = now + m_settings_.retransmit_interval;
+        }
+
+        if(p.retransmits < m_settings_.max_retransmits) next = (std::min)(next, p.retransmit_at);
+      }
+
+      next = (std::min)(next, p.deadline);
+      ++it;
+    }
+
+    return next;
+  }
+
+public:
+  PipelinedClient(Socket<SI, INV, SCS>& sock, const PipelineSettings& settings = {}) :
+    m_sock_(sock), m_settings_(settings)
+  {
+    if constexpr(SI.type == SocketType::Stream) m_rx_.resize(rx_capacity);
+  }
+
+  PipelinedClient(const PipelinedClient&) = delete;
+  PipelinedClient& operator=(const PipelinedClient&) = delete;
+
+  std::size_t in_flight() const noexcept { return m_pending_.size(); }
+
+  //Sends request, fails with invalid_argument if request with same correlation id is in flight
+  //and with no_buffer_space if max_in_flight requests are in flight
+  template<auto EHP = ehl::Policy::Exception>
+  [[nodiscard]] ehl::Result_t<void, sys_errc::ErrorCode, EHP> send(
+    const valid_packet<request_type>& req,
+    std::chrono::milliseconds timeout) noexcept(EHP != ehl::Policy::Exception)
+  {
+    const request_type& r = req;
+    const auto key = details::correlation_key(r.*ReqId);
+
+    EHL_THROW_IF(m_pending_.contains(key), invalid_argument_err);
+    EHL_THROW_IF(m_pending_.size() >= m_settings_.max_in_flight, no_buffer_space_err);
+    EHL_THROW_IF(!write(r), sys_errc::last_error());
+
+    const auto now = clock::now();
+    m_pending_.emplace(key, pending_request{r, now + timeout, now + m_settings_.retransmit_interval, 0});
+  }
+
+  template<auto EHP = ehl::Policy::Exception>
+  [[nodiscard]] ehl::Result_t<void, sys_errc::ErrorCode, EHP> send(const valid_packet<request_type>& req)
+    noexcept(EHP != ehl::Policy::Exception)
+  {
+    return send<EHP>(req, m_settings_.timeout);
+  }
+
+  template<auto EHP = ehl::Policy::Exception>
+  [[nodiscard]] ehl::Result_t<void, sys_errc::ErrorCode, EHP> send(const request_type& req, std::chrono::milliseconds timeout)
+    noexcept(EHP != ehl::Policy::Exception)
+  {
+    EHL_THROW_IF(!req.is_valid(), invalid_argument_err);
+
+    return send<EHP>(std::bit_cast<valid_packet<request_type>>(req), timeout);
+  }
+
+  template<auto EHP = ehl::Policy::Exception>
+  [[nodiscard]] ehl::Result_t<void, sys_errc::ErrorCode, EHP> send(const request_type& req)
+    noexcept(EHP != ehl::Policy::Exception)
+  {
+    return send<EHP>(req, m_settings_.timeout);
+  }
+
+  //Waits up to timeout_ms (-1 is infinite) for at least one request to complete,
+  //calls on_reply(request, valid_packet<reply_type>) for answered and on_timeout(request) for expired requests,
+  //returns number of completed requests, 0 on timeout or when nothing is in flight
+  template<auto EHP = ehl::Policy::Exception, typename OnReply, typename OnTimeout>
+  [[nodiscard]] ehl::Result_t<std::size_t, sys_errc::ErrorCode, EHP> process(
+    int timeout_ms, OnReply&& on_reply, OnTimeout&& on_timeout) noexcept(EHP != ehl::Policy::Exception)
+  {
+    const auto until = timeout_ms < 0 ? clock::time_point::max() : clock::now() + std::chrono::milliseconds(timeout_ms);
+    std::size_t done = 0;
+    bool polled = false;
+
+    while(!m_pending_.empty())
+    {
+      auto now = clock::now();
+      const auto next_timer = run_timers(now, on_timeout, done);
+
+      //socket is polled at least once, so expired timeout still takes queued replies
+      if(done != 0 || m_pending_.empty() || (polled && now >= until)) break;
+
+      const auto wake = (std::min)(until, next_timer);
+      const auto wait = wake <= now ? 0 : (std::min)(
+        std::chrono::ceil<std::chrono::milliseconds>(wake - now).count(),
+        static_cast<std::chrono::milliseconds::rep>(std::numeric_limits<int>::max()));
+
+      pollfd fd{ .fd = details::socket_access::handle(m_sock_), .events = std::to_underlying(PollFlags::In), .revents = 0 };
+      int r = HPP_IFE(HPP_WIN_IMPL)(::WSAPoll)(::poll)(&fd, 1, static_cast<int>(wait));
+
+      polled = true;
+
+      //replies are read while socket stays readable
+      while(r > 0)
+      {
+        sys_errc::ErrorCode err = not_connected_err;
+        const auto n = read_replies(on_reply, err);
+
+        EHL_THROW_IF(n < 0, err);
+
+        done += static_cast<std::size_t>(n);
+
+        r = HPP_IFE(HPP_WIN_IMPL)(::WSAPoll)(::poll)(&fd, 1, 0);
+      }
+
+      EHL_THROW_IF(r < 0, sys_errc::last_error());
+
+      if(done != 0) break;
+    }
+
+    return done;
+  }
+};
+
+//PipelinedClient for sock with correlation fields ReqId/RepId, e.g. make_pipelined_client<&Req::id, &Rep::id>(sock)
+template<auto ReqId, auto RepId, SocketInfo SI, InvInfo INV, ConnectionSettings SCS>
+PipelinedClient<SI, INV, SCS, ReqId, RepId> make_pipelined_client(Socket<SI, INV, SCS>& sock, const PipelineSettings& settings = {})
+{
+  return PipelinedClient<SI, INV, SCS, ReqId, RepId>(sock, settings);
+}
+
+} //namespace cpps
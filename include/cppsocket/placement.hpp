@@ -0,0 +1,228 @@
+#pragma once
+
+#include "details/platform_headers.hpp"
+
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <optional>
+#include <span>
+#include <utility>
+#include "socket.hpp"
+#include "details/socket_access.hpp"
+
+#if defined(__linux__)
+  #include <dirent.h>
+  #include <sched.h>
+  #include <sys/mman.h>
+#elif HPP_POSIX_IMPL
+  #include <sys/mman.h>
+#endif
+
+namespace cpps
+{
+
+namespace details
+{
+
+//returns CPU which processed last packet of socket (Linux only), -1 when it is unknown
+inline int incoming_cpu(socket_resource::Handle h) noexcept
+{
+#if defined(SO_INCOMING_CPU)
+  int cpu = -1;
+  socklen_type len = sizeof(cpu);
+
+  if(::getsockopt(h, SOL_SOCKET, SO_INCOMING_CPU, &cpu, &len) != 0) return -1;
+
+  return cpu;
+#else
+  (void)h;
+  return -1;
+#endif
+}
+
+} //namespace details
+
+//CPU calling thread is running on
+inline std::optional<unsigned> current_cpu() noexcept
+{
+#if defined(__linux__)
+  int cpu = ::sched_getcpu();
+
+  if(cpu < 0) return std::nullopt;
+
+  return static_cast<unsigned>(cpu);
+#elif HPP_WIN_IMPL
+  return static_cast<unsigned>(::GetCurrentProcessorNumber());
+#else
+  return std::nullopt;
+#endif
+}
+
+//NUMA node of CPU, 0 on single node hosts and where topology is unknown
+inline unsigned numa_node(unsigned cpu) noexcept
+{
+#if defined(__linux__)
+  char path[64];
+  std::snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%u", cpu);
+
+  DIR* dir = ::opendir(path);
+
+  if(!dir) return 0;
+
+  unsigned node = 0;
+
+  //directory of CPU has link named after its node
+  while(const dirent* e = ::readdir(dir))
+    if(std::strncmp(e->d_name, "node", 4) == 0 && std::sscanf(e->d_name + 4, "%u", &node) == 1) break;
+
+  ::closedir(dir);
+
+  return node;
+#else
+  (void)cpu;
+  return 0;
+#endif
+}
+
+#if defined(__linux__) || HPP_WIN_IMPL
+//Pins calling thread to CPU, so its socket processing shares caches with NIC queue interrupts of that CPU
+//and memory it touches first is allocated on node of that CPU
+template<auto EHP = ehl::Policy::Exception>
+[[nodiscard]] ehl::Result_t<void, sys_errc::ErrorCode, EHP> pin_current_thread(unsigned cpu)
+  noexcept(EHP != ehl::Policy::Exception)
+{
+#if defined(__linux__)
+  EHL_THROW_IF(cpu >= CPU_SETSIZE, sys_errc::ErrorCode(sys_errc::common::sockets::invalid_argument));
+
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+
+  int r = ::sched_setaffinity(0, sizeof(set), &set);
+
+  EHL_THROW_IF(r != 0, sys_errc::last_error());
+#else
+  EHL_THROW_IF(cpu >= sizeof(DWORD_PTR) * 8, sys_errc::ErrorCode(sys_errc::common::sockets::invalid_argument));
+
+  auto r = ::SetThreadAffinityMask(::GetCurrentThread(), DWORD_PTR{1} << cpu);
+
+  EHL_THROW_IF(r == 0, sys_errc::last_error());
+#endif
+}
+#endif
+
+//CPU which processed last received packet of socket (SO_INCOMING_CPU), for connection it is CPU
+//serving NIC receive queue of its flow when receive side scaling steers flows to CPUs.
+//Empty when it is unknown (nothing received yet or not supported by platform)
+template<auto EHP = ehl::Policy::Exception, SocketInfo SI, InvInfo INV, ConnectionSettings SCS>
+[[nodiscard]] ehl::Result_t<std::optional<unsigned>, sys_errc::ErrorCode, EHP> incoming_cpu(
+  const Socket<SI, INV, SCS>& sock)
+    noexcept(EHP != ehl::Policy::Exception)
+{
+  int cpu = details::incoming_cpu(details::socket_access::handle(sock));
+
+  if(cpu < 0) return std::optional<unsigned>{};
+
+  return std::optional<unsigned>{static_cast<unsigned>(cpu)};
+}
+
+//Id of NIC receive queue (NAPI context) which delivered last received packet of socket,
+//sockets with same id are served by same queue and interrupt.
+//Empty when it is unknown (loopback, nothing received yet or not supported by platform)
+template<auto EHP = ehl::Policy::Exception, SocketInfo SI, InvInfo INV, ConnectionSettings SCS>
+[[nodiscard]] ehl::Result_t<std::optional<unsigned>, sys_errc::ErrorCode, EHP> incoming_napi_id(
+  const Socket<SI, INV, SCS>& sock)
+    noexcept(EHP != ehl::Policy::Exception)
+{
+#if defined(SO_INCOMING_NAPI_ID)
+  unsigned id = 0;
+  details::socklen_type len = sizeof(id);
+
+  int r = ::getsockopt(details::socket_access::handle(sock), SOL_SOCKET, SO_INCOMING_NAPI_ID, &id, &len);
+
+  EHL_THROW_IF(r != 0, sys_errc::last_error());
+
+  if(id == 0) return std::optional<unsigned>{};
+
+  return std::optional<unsigned>{id};
+#else
+  (void)sock;
+  return std::optional<unsigned>{};
+#endif
+}
+
+//Page aligned buffer placed on NUMA node of thread which makes it: pages are touched on creation,
+//and first touch policy of kernel allocates them on node of touching CPU.
+//Should be made by worker after it is pinned, so its packet buffers do not cross interconnect
+class LocalBuffer
+{
+  std::byte* m_data_ = nullptr;
+  std::size_t m_size_ = 0;
+
+  LocalBuffer(std::byte* data, std::size_t size) noexcept : m_data_(data), m_size_(size) {}
+
+public:
+  template<auto EHP = ehl::Policy::Exception>
+  [[nodiscard]] static ehl::Result_t<LocalBuffer, sys_errc::ErrorCode, EHP> make(std::size_t size)
+    noexcept(EHP != ehl::Policy::Exception)
+  {
+    EHL_THROW_IF(size == 0, sys_errc::ErrorCode(sys_errc::common::sockets::invalid_argument));
+
+#if HPP_WIN_IMPL
+    void* p = ::VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+
+    EHL_THROW_IF(p == nullptr, sys_errc::last_error());
+
+    const std::size_t page = 4096;
+#else
+    void* p = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    EHL_THROW_IF(p == MAP_FAILED, sys_errc::last_error());
+
+    const auto page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+#endif
+
+    auto* data = static_cast<std::byte*>(p);
+
+    //volatile so touches are not elided as stores to fresh memory
+    for(std::size_t i = 0; i < size; i += page) *static_cast<volatile std::byte*>(data + i) = std::byte{0};
+
+    return LocalBuffer(data, size);
+  }
+
+  LocalBuffer(LocalBuffer&& b) noexcept :
+    m_data_(std::exchange(b.m_data_, nullptr)),
+    m_size_(std::exchange(b.m_size_, 0)) {}
+
+  LocalBuffer& operator=(LocalBuffer&& b) noexcept
+  {
+    LocalBuffer tmp(std::move(b));
+
+    std::swap(m_data_, tmp.m_data_);
+    std::swap(m_size_, tmp.m_size_);
+
+    return *this;
+  }
+
+  ~LocalBuffer()
+  {
+    if(!m_data_) return;
+
+#if HPP_WIN_IMPL
+    ::VirtualFree(m_data_, 0, MEM_RELEASE);
+#else
+    ::munmap(m_data_, m_size_);
+#endif
+  }
+
+  std::byte* data() const noexcept { return m_data_; }
+  std::size_t size() const noexcept { return m_size_; }
+
+  std::span<std::byte> span() const noexcept
+  {
+    return { m_data_, m_size_ };
+  }
+};
+
+} //namespace cpps
@@ -0,0 +1,667 @@
+#pragma once
+
+#include "details/platform_headers.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "socket.hpp"
+#include "details/batch_io.hpp"
+#include "details/nonblocking.hpp"
+#include "details/socket_access.hpp"
+
+#if defined(__linux__)
+  #include <fcntl.h>
+#endif
+
+namespace cpps
+{
+
+struct RelaySettings
+{
+  //every n-th packet is validated as packet type of relay before it is forwarded,
+  //invalid one is dropped, 0 disables sampling.
+  //Stream relay stops at each sampled packet, so frequent sampling of small packets reduces throughput
+  unsigned sample_every = 0;
+
+  //most bytes moved by one step of stream relay
+  std::size_t chunk_size = 65536;
+
+  //datagrams longer than this are dropped by datagram relay
+  std::size_t datagram_size = 2048;
+};
+
+struct RelayStats
+{
+  //bytes taken from source, including dropped ones
+  std::uint64_t bytes = 0;
+  //forwarded datagrams, datagram relay only
+  std::uint64_t datagrams = 0;
+  std::uint64_t sampled = 0;
+  std::uint64_t dropped = 0;
+};
+
+namespace details
+{
+
+inline int shutdown_send(socket_resource::Handle h) noexcept
+{
+  return ::shutdown(h, HPP_IFE(HPP_WIN_IMPL)(SD_SEND)(SHUT_WR));
+}
+
+template<typename T, ConnectionSettings CS>
+bool valid_wire_packet(const void* data) noexcept
+{
+  T t;
+  std::memcpy(&t, data, sizeof(T));
+
+  if constexpr(CS.convert_byte_order)
+    details::convert_byte_order(t);
+
+  return t.is_valid();
+}
+
+//One direction of stream relay: data is moved from socket to pipe and from pipe to socket by splice,
+//so it is not copied to user space. Where splice is not available (or not supported by socket)
+//data is copied through buffer.
+//Bytes taken from source stay pending until they are written, so on non-blocking sockets source is read
+//again only after destination took all of them.
+//With sampling, stream is assumed to carry T back to back, so each n-th packet starts at known offset,
+//sampled packets are gathered in buffer and decoded with connection settings CS given to pull
+template<typename T>
+class stream_forwarder
+{
+  static constexpr std::size_t sample_size = []
+  {
+    if constexpr(std::is_void_v<T>)
+      return std::size_t{0};
+    else
+      return sizeof(T);
+  }();
+
+#if defined(__linux__)
+  int m_pipe_[2] = { -1, -1 };
+  bool m_splice_ = true;
+  //pending bytes in pipe
+  std::size_t m_piped_ = 0;
+#endif
+  std::vector<std::byte> m_buffer_;
+  //pending bytes in buffer, starting at offset
+  std::size_t m_offset_ = 0;
+  std::size_t m_pending_ = 0;
+  std::size_t m_chunk_size_ = 0;
+  unsigned m_sample_every_ = 0;
+  //bytes until start of next sampled packet
+  std::size_t m_until_sample_ = 0;
+  //bytes of sampled packet gathered at start of buffer
+  std::size_t m_sampled_ = 0;
+  RelayStats m_stats_;
+
+  bool resize_buffer(std::size_t size) noexcept
+  {
+    try
+    {
+      m_buffer_.resize(size);
+    }
+    catch(...)
+    {
+      return false;
+    }
+
+    return true;
+  }
+
+  //gathers packet at start of stream, valid one becomes pending and invalid one is dropped,
+  //returns bytes taken from source, 0 at end of stream or -1 on error
+  template<ConnectionSettings CS>
+  std::ptrdiff_t sample(socket_resource::Handle from) noexcept
+  {
+    const std::size_t missing = sample_size - m_sampled_;
+
+    auto r = ::recv(
+      from, reinterpret_cast<char*>(m_buffer_.data() + m_sampled_), HPP_IFE(HPP_WIN_IMPL)(static_cast<int>(missing))(missing),
+      HPP_IFE(HPP_WIN_IMPL)(0)(MSG_WAITALL));
+
+    if(r < 0) return r;
+
+    //stream ends inside of packet, rest is forwarded as is
+    if(r == 0)
+    {
+      m_offset_ = 0;
+      m_pending_ = std::exchange(m_sampled_, 0);
+
+      return 0;
+    }
+
+    m_stats_.bytes += static_cast<std::size_t>(r);
+    m_sampled_ += static_cast<std::size_t>(r);
+
+    if(m_sampled_ != sample_size) return r;
+
+    m_sampled_ = 0;
+    m_until_sample_ = (m_sample_every_ - 1) * sample_size;
+    ++m_stats_.sampled;
+
+    if(valid_wire_packet<T, CS>(m_buffer_.data()))
+    {
+      m_offset_ = 0;
+      m_pending_ = sample_size;
+    }
+    else
+      ++m_stats_.dropped;
+
+    return r;
+  }
+
+public:
+  stream_forwarder() = default;
+
+  stream_forwarder(stream_forwarder&& f) noexcept :
+#if defined(__linux__)
+    m_pipe_{ std::exchange(f.m_pipe_[0], -1), std::exchange(f.m_pipe_[1], -1) },
+    m_splice_(f.m_splice_),
+    m_piped_(f.m_piped_),
+#endif
+    m_buffer_(std::move(f.m_buffer_)),
+    m_offset_(f.m_offset_),
+    m_pending_(f.m_pending_),
+    m_chunk_size_(f.m_chunk_size_),
+    m_sample_every_(f.m_sample_every_),
+    m_until_sample_(f.m_until_sample_),
+    m_sampled_(f.m_sampled_),
+    m_stats_(f.m_stats_) {}
+
+  stream_forwarder& operator=(stream_forwarder&& f) noexcept
+  {
+    stream_forwarder tmp(std::move(f));
+
+#if defined(__linux__)
+    std::swap(m_pipe_, tmp.m_pipe_);
+    std::swap(m_splice_, tmp.m_splice_);
+    std::swap(m_piped_, tmp.m_piped_);
+#endif
+    std::swap(m_buffer_, tmp.m_buffer_);
+    std::swap(m_offset_, tmp.m_offset_);
+    std::swap(m_pending_, tmp.m_pending_);
+    std::swap(m_chunk_size_, tmp.m_chunk_size_);
+    std::swap(m_sample_every_, tmp.m_sample_every_);
+    std::swap(m_until_sample_, tmp.m_until_sample_);
+    std::swap(m_sampled_, tmp.m_sampled_);
+    std::swap(m_stats_, tmp.m_stats_);
+
+    return *this;
+  }
+
+  ~stream_forwarder()
+  {
+#if defined(__linux__)
+    if(m_pipe_[0] >= 0) ::close(m_pipe_[0]);
+    if(m_pipe_[1] >= 0) ::close(m_pipe_[1]);
+#endif
+  }
+
+  //returns false on error
+  bool open(const RelaySettings& settings) noexcept
+  {
+    m_chunk_size_ = (std::max)(settings.chunk_size, std::size_t{1});
+    m_sample_every_ = std::is_void_v<T> ? 0 : settings.sample_every;
+
+    //buffer always holds whole sampled packet
+    const std::size_t sample_buffer = m_sample_every_ != 0 ? sample_size : 0;
+
+#if defined(__linux__)
+    if(::pipe2(m_pipe_, O_CLOEXEC) != 0) return false;
+
+    //pipe must hold whole chunk, otherwise chunk is shrunk to pipe capacity
+    int capacity = ::fcntl(m_pipe_[1], F_SETPIPE_SZ, static_cast<int>((std::min)(m_chunk_size_, std::size_t{1} << 20)));
+    if(capacity < 0) capacity = ::fcntl(m_pipe_[1], F_GETPIPE_SZ);
+    if(capacity > 0) m_chunk_size_ = (std::min)(m_chunk_size_, static_cast<std::size_t>(capacity));
+
+    return resize_buffer(sample_buffer);
+#else
+    return resize_buffer((std::max)(m_chunk_size_, sample_buffer));
+#endif
+  }
+
+  //bytes taken from source but not written to destination yet
+  std::size_t pending() const noexcept
+  {
+#if defined(__linux__)
+    return m_pending_ + m_piped_;
+#else
+    return m_pending_;
+#endif
+  }
+
+  //takes available bytes from source (waits for at least one on blocking socket), must be called without pending bytes,
+  //returns number of bytes taken, 0 at end of stream or -1 on error
+  template<ConnectionSettings CS>
+  std::ptrdiff_t pull(socket_resource::Handle from) noexcept
+  {
+    std::size_t limit = m_chunk_size_;
+
+    if constexpr(!std::is_void_v<T>)
+    {
+      if(m_sample_every_ != 0)
+      {
+        if(m_until_sample_ == 0) return sample<CS>(from);
+
+        limit = (std::min)(limit, m_until_sample_);
+      }
+    }
+
+    std::ptrdiff_t n = -2;
+
+#if defined(__linux__)
+    if(m_splice_)
+    {
+      n = ::splice(from, nullptr, m_pipe_[1], nullptr, limit, SPLICE_F_MOVE);
+
+      //nothing is moved yet, copying takes over for good
+      if(n < 0 && errno == EINVAL)
+      {
+        m_splice_ = false;
+        n = -2;
+
+        if(!resize_buffer((std::max)(m_chunk_size_, m_buffer_.size())))
+        {
+          errno = ENOMEM;
+          return -1;
+        }
+      }
+      else if(n > 0)
+        m_piped_ = static_cast<std::size_t>(n);
+    }
+#endif
+
+    if(n == -2)
+    {
+      n = ::recv(from, reinterpret_cast<char*>(m_buffer_.data()), HPP_IFE(HPP_WIN_IMPL)(static_cast<int>(limit))(limit), 0);
+
+      if(n > 0)
+      {
+        m_offset_ = 0;
+        m_pending_ = static_cast<std::size_t>(n);
+      }
+    }
+
+    if(n > 0)
+    {
+      m_stats_.bytes += static_cast<std::size_t>(n);
+      if(m_sample_every_ != 0) m_until_sample_ -= static_cast<std::size_t>(n);
+    }
+
+    return n;
+  }
+
+  //writes pending bytes until all are written or destination would block,
+  //returns number of bytes still pending or -1 on error
+  std::ptrdiff_t flush(socket_resource::Handle to) noexcept
+  {
+    while(m_pending_ != 0)
+    {
+      auto w = ::send(
+        to, reinterpret_cast<const char*>(m_buffer_.data() + m_offset_),
+        HPP_IFE(HPP_WIN_IMPL)(static_cast<int>(m_pending_))(m_pending_), 0);
+
+      if(w < 0) return last_error_would_block() ? static_cast<std::ptrdiff_t>(pending()) : -1;
+
+      m_offset_ += static_cast<std::size_t>(w);
+      m_pending_ -= static_cast<std::size_t>(w);
+    }
+
+#if defined(__linux__)
+    while(m_piped_ != 0)
+    {
+      auto w = ::splice(m_pipe_[0], nullptr, to, nullptr, m_piped_, SPLICE_F_MOVE);
+
+      if(w < 0) return last_error_would_block() ? static_cast<std::ptrdiff_t>(m_piped_) : -1;
+
+      m_piped_ -= static_cast<std::size_t>(w);
+    }
+#endif
+
+    return 0;
+  }
+
+  //moves available bytes between blocking sockets (waits for at least one),
+  //returns number of bytes taken from source, 0 at end of stream or -1 on error
+  template<ConnectionSettings CS>
+  std::ptrdiff_t step(socket_resource::Handle from, socket_resource::Handle to) noexcept
+  {
+    auto n = pull<CS>(from);
+
+    //blocking destination takes all pending bytes, also ones left by end of stream inside of sampled packet
+    if(pending() != 0 && flush(to) != 0) return -1;
+
+    return n;
+  }
+
+  const RelayStats& stats() const noexcept
+  {
+    return m_stats_;
+  }
+};
+
+//relays both directions between non-blocking stream sockets until both sources reached end of stream
+//and everything taken from them was written, returns error of failed call
+template<ConnectionSettings CS, typename AtoB, typename BtoA>
+std::optional<sys_errc::ErrorCode> relay_nonblocking(
+  socket_resource::Handle ha, socket_resource::Handle hb, stream_forwarder<AtoB>& a_to_b, stream_forwarder<BtoA>& b_to_a)
+    noexcept
+{
+  constexpr short failed = POLLERR | POLLHUP;
+
+  bool a_open = true;
+  bool b_open = true;
+
+  //source is read only when everything taken from it was written, so full destination
+  //stops only its own direction, and end of stream is passed on by shutting down sending after last byte
+  const auto advance = [](auto& f, socket_resource::Handle from, socket_resource::Handle to, bool& open)
+  {
+    const bool active = open || f.pending() != 0;
+
+    if(f.flush(to) < 0) return false;
+
+    if(open && f.pending() == 0)
+    {
+      const auto n = f.template pull<CS>(from);
+
+      if(n < 0) return last_error_would_block();
+
+      open = n != 0;
+
+      if(f.flush(to) < 0) return false;
+    }
+
+    if(active && !open && f.pending() == 0) shutdown_send(to);
+
+    return true;
+  };
+
+  while(a_open || b_open || a_to_b.pending() != 0 || b_to_a.pending() != 0)
+  {
+    const short a_events = (a_open && a_to_b.pending() == 0 ? POLLIN : 0) | (b_to_a.pending() != 0 ? POLLOUT : 0);
+    const short b_events = (b_open && b_to_a.pending() == 0 ? POLLIN : 0) | (a_to_b.pending() != 0 ? POLLOUT : 0);
+
+    pollfd fds[2];
+    unsigned count = 0;
+
+    if(a_events != 0) fds[count++] = { .fd = ha, .events = a_events, .revents = 0 };
+    if(b_events != 0) fds[count++] = { .fd = hb, .events = b_events, .revents = 0 };
+
+    auto r = HPP_IFE(HPP_WIN_IMPL)(::WSAPoll)(::poll)(fds, count, -1);
+
+    if(r < 0 && HPP_IFE(HPP_WIN_IMPL)(false)(errno == EINTR)) continue;
+    if(r < 0) return sys_errc::last_error();
+
+    short a_revents = 0;
+    short b_revents = 0;
+
+    for(unsigned i = 0; i != count; ++i) (fds[i].fd == ha ? a_revents : b_revents) = fds[i].revents;
+
+    if((a_revents & (POLLIN | failed)) || (b_revents & (POLLOUT | failed)))
+      if(!advance(a_to_b, ha, hb, a_open)) return sys_errc::last_error();
+
+    if((b_revents & (POLLIN | failed)) || (a_revents & (POLLOUT | failed)))
+      if(!advance(b_to_a, hb, ha, b_open)) return sys_errc::last_error();
+  }
+
+  return std::nullopt;
+}
+
+} //namespace details
+
+//Forwards bytes from one connected stream socket to another without decoding them,
+//zero copy by splice on Linux. T (optional) is packet type used to validate sampled packets.
+//Bytes are not re-encoded, so both sockets must have same connection settings, not negotiated per connection;
+//sampled packets are decoded with them
+template<typename T = void>
+  requires (std::is_void_v<T> || packet_type<T>)
+class StreamRelay
+{
+  details::stream_forwarder<T> m_forwarder_;
+
+  StreamRelay(details::stream_forwarder<T>&& f) noexcept : m_forwarder_(std::move(f)) {}
+
+public:
+  template<auto EHP = ehl::Policy::Exception>
+  [[nodiscard]] static ehl::Result_t<StreamRelay, sys_errc::ErrorCode, EHP> make(const RelaySettings& settings = {})
+    noexcept(EHP != ehl::Policy::Exception)
+  {
+    details::stream_forwarder<T> f;
+
+    EHL_THROW_IF(!f.open(settings), sys_errc::last_error());
+
+    return StreamRelay(std::move(f));
+  }
+
+  //moves bytes available on from to to, waits until some are available and until all are written,
+  //returns number of bytes taken from from, 0 when its peer finished sending.
+  //Forwarding both directions of connection from one thread can deadlock when both peers send more
+  //than socket buffers hold, so each direction needs own thread (relay forwards both without blocking)
+  template<
+    auto EHP = ehl::Policy::Exception,
+    SocketInfo SI1, InvInfo INV1, ConnectionSettings SCS1,
+    SocketInfo SI2, InvInfo INV2, ConnectionSettings SCS2>
+    requires (SI1.type == SocketType::Stream && SI2.type == SocketType::Stream && INV1.connected && INV2.connected)
+  [[nodiscard]] ehl::Result_t<std::size_t, sys_errc::ErrorCode, EHP> forward(
+    Socket<SI1, INV1, SCS1>& from, Socket<SI2, INV2, SCS2>& to)
+      noexcept(EHP != ehl::Policy::Exception)
+  {
+    static_assert(SCS1 == SCS2 && !SCS1.negotiate_byte_order, "relayed sockets must have same fixed connection settings");
+    static_assert(std::is_void_v<T> || raw_settings<SCS1>, "sampled packets must be raw encoded");
+
+    auto n = m_forwarder_.template step<SCS1>(details::socket_access::handle(from), details::socket_access::handle(to));
+
+    EHL_THROW_IF(n < 0, sys_errc::last_error());
+
+    return static_cast<std::size_t>(n);
+  }
+
+  const RelayStats& stats() const noexcept
+  {
+    return m_forwarder_.stats();
+  }
+};
+
+//Forwards both directions between connected stream sockets until both peers finished sending,
+//end of stream of one peer is passed to other by shutting down sending.
+//AtoB and BtoA (optional) are packet types used to validate sampled packets of each direction.
+//Sockets must have same connection settings, as for StreamRelay
+template<
+  typename AtoB = void, typename BtoA = void,
+  auto EHP = ehl::Policy::Exception,
+  SocketInfo SI1, InvInfo INV1, ConnectionSettings SCS1,
+  SocketInfo SI2, InvInfo INV2, ConnectionSettings SCS2>
+  requires
+    (std::is_void_v<AtoB> || packet_type<AtoB>) && (std::is_void_v<BtoA> || packet_type<BtoA>) &&
+    (SI1.type == SocketType::Stream && SI2.type == SocketType::Stream && INV1.connected && INV2.connected)
+[[nodiscard]] ehl::Result_t<void, sys_errc::ErrorCode, EHP> relay(
+  Socket<SI1, INV1, SCS1>& a, Socket<SI2, INV2, SCS2>& b, const RelaySettings& settings = {})
+    noexcept(EHP != ehl::Policy::Exception)
+{
+  static_assert(SCS1 == SCS2 && !SCS1.negotiate_byte_order, "relayed sockets must have same fixed connection settings");
+  static_assert((std::is_void_v<AtoB> && std::is_void_v<BtoA>) || raw_settings<SCS1>, "sampled packets must be raw encoded");
+
+  const details::socket_resource::Handle ha = details::socket_access::handle(a);
+  const details::socket_resource::Handle hb = details::socket_access::handle(b);
+
+  details::stream_forwarder<AtoB> a_to_b;
+  details::stream_forwarder<BtoA> b_to_a;
+
+  EHL_THROW_IF(!a_to_b.open(settings) || !b_to_a.open(settings), sys_errc::last_error());
+
+  std::optional<sys_errc::ErrorCode> err;
+
+  //blocking write of one direction could wait for peer which itself waits for other direction to be read
+  if(details::set_nonblocking(ha, true) != 0 || details::set_nonblocking(hb, true) != 0)
+    err = sys_errc::last_error();
+  else
+    err = details::relay_nonblocking<SCS1>(ha, hb, a_to_b, b_to_a);
+
+  //sockets are handed back blocking, as Net makes them
+  if((details::set_nonblocking(ha, false) != 0 || details::set_nonblocking(hb, false) != 0) && !err)
+    err = sys_errc::last_error();
+
+  EHL_THROW_IF(err.has_value(), *err);
+}
+
+//Forwards datagrams from one socket to another in batches without decoding them.
+//T (optional) is packet type used to validate sampled datagrams.
+//Both sockets must have same connection settings, sampled datagrams are decoded with them
+template<typename T = void>
+  requires (std::is_void_v<T> || packet_type<T>)
+class DatagramRelay
+{
+
+  std::vector<std::byte> m_buffer_;
+  std::size_t m_datagram_size_;
+  unsigned m_sample_every_;
+  //datagrams until next sampled one
+  unsigned m_until_sample_ = 0;
+  RelayStats m_stats_;
+
+  DatagramRelay(std::vector<std::byte>&& buffer, const RelaySettings& settings) noexcept :
+    m_buffer_(std::move(buffer)),
+    m_datagram_size_(settings.datagram_size),
+    m_sample_every_(std::is_void_v<T> ? 0 : settings.sample_every) {}
+
+  //returns false when datagram is dropped
+  template<ConnectionSettings CS>
+  bool accept(const details::incoming_datagram& d) noexcept
+  {
+    m_stats_.bytes += d.received;
+
+    //one more byte than datagram_size is received to detect longer datagrams
+    bool ok = d.received <= m_datagram_size_;
+
+    if constexpr(!std::is_void_v<T>)
+    {
+      if(ok && m_sample_every_ != 0 && m_until_sample_-- == 0)
+      {
+        m_until_sample_ = m_sample_every_ - 1;
+        ++m_stats_.sampled;
+
+        ok = d.received == sizeof(T) && details::valid_wire_packet<T, CS>(d.data);
+      }
+    }
+
+    if(!ok) ++m_stats_.dropped;
+
+    return ok;
+  }
+
+  //returns number of forwarded datagrams or -1 on error
+  template<ConnectionSettings CS>
+  int step(details::socket_resource::Handle from, details::socket_resource::Handle to, const sockaddr* addr, details::socklen_type addrlen)
+    noexcept
+  {
+    const std::size_t slot = m_datagram_size_ + 1;
+
+    details::incoming_datagram in[details::max_batch_size];
+
+    for(unsigned i = 0; i != details::max_batch_size; ++i)
+      in[i] = { m_buffer_.data() + i * slot, slot, nullptr, 0, 0 };
+
+    int r = details::recv_datagrams(from, in, details::max_batch_size);
+
+    if(r < 0) return -1;
+
+    details::outgoing_datagram out[details::max_batch_size];
+    unsigned count = 0;
+
+    for(int i = 0; i != r; ++i)
+      if(accept<CS>(in[i])) out[count++] = { { in[i].data, in[i].received }, addr, addrlen };
+
+    for(unsigned sent = 0; sent != count;)
+    {
+      int s = details::send_datagrams(to, out + sent, count - sent);
+
+      if(s < 0) return -1;
+
+      sent += static_cast<unsigned>(s);
+    }
+
+    m_stats_.datagrams += count;
+
+    return static_cast<int>(count);
+  }
+
+public:
+  template<auto EHP = ehl::Policy::Exception>
+  [[nodiscard]] static ehl::Result_t<DatagramRelay, sys_errc::ErrorCode, EHP> make(const RelaySettings& settings = {})
+    noexcept(EHP != ehl::Policy::Exception)
+  {
+    std::vector<std::byte> buffer;
+
+    try
+    {
+      buffer.resize(details::max_batch_size * (settings.datagram_size + 1));
+    }
+    catch(...)
+    {
+      EHL_THROW_IF(true, sys_errc::ErrorCode(sys_errc::common::sockets::no_buffer_space));
+    }
+
+    return DatagramRelay(std::move(buffer), settings);
+  }
+
+  //forwards batch of datagrams received on from to connected to, waits for first one,
+  //returns number of forwarded datagrams
+  template<
+    auto EHP = ehl::Policy::Exception,
+    SocketInfo SI1, InvInfo INV1, ConnectionSettings SCS1,
+    SocketInfo SI2, InvInfo INV2, ConnectionSettings SCS2>
+    requires (SI1.type == SocketType::Datagram && SI2.type == SocketType::Datagram && INV2.connected)
+  [[nodiscard]] ehl::Result_t<std::size_t, sys_errc::ErrorCode, EHP> forward(
+    Socket<SI1, INV1, SCS1>& from, Socket<SI2, INV2, SCS2>& to)
+      noexcept(EHP != ehl::Policy::Exception)
+  {
+    static_assert(SCS1 == SCS2, "relayed sockets must have same connection settings");
+    static_assert(std::is_void_v<T> || raw_unchecked_settings<SCS1>, "sampled datagrams must be raw encoded without checksum");
+
+    int r = step<SCS1>(details::socket_access::handle(from), details::socket_access::handle(to), nullptr, 0);
+
+    EHL_THROW_IF(r < 0, sys_errc::last_error());
+
+    return static_cast<std::size_t>(r);
+  }
+
+  //forwards batch of datagrams received on from to dest
+  template<
+    auto EHP = ehl::Policy::Exception,
+    SocketInfo SI1, InvInfo INV1, ConnectionSettings SCS1,
+    SocketInfo SI2, InvInfo INV2, ConnectionSettings SCS2>
+    requires (SI1.type == SocketType::Datagram && SI2.type == SocketType::Datagram)
+  [[nodiscard]] ehl::Result_t<std::size_t, sys_errc::ErrorCode, EHP> forward(
+    Socket<SI1, INV1, SCS1>& from, Socket<SI2, INV2, SCS2>& to, const Address<SI2.address_family>& dest)
+      noexcept(EHP != ehl::Policy::Exception)
+  {
+    static_assert(SCS1 == SCS2, "relayed sockets must have same connection settings");
+    static_assert(std::is_void_v<T> || raw_unchecked_settings<SCS1>, "sampled datagrams must be raw encoded without checksum");
+
+    int r = step<SCS1>(
+      details::socket_access::handle(from),
+      details::socket_access::handle(to),
+      details::to_sockaddr_ptr(&dest),
+      details::sockaddr_length(dest));
+
+    EHL_THROW_IF(r < 0, sys_errc::last_error());
+
+    return static_cast<std::size_t>(r);
+  }
+
+  const RelayStats& stats() const noexcept
+  {
+    return m_stats_;
+  }
+};
+
+} //namespace cpps
@@ -0,0 +1,532 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <variant>
+#include <vector>
+#include "socket.hpp"
+#include "details/batch_io.hpp"
+#include "details/socket_access.hpp"
+
+namespace cpps
+{
+
+//Packet types ReliableChannel delivers as soon as they arrive instead of in sequence order,
+//e.g. independent snapshots which must not wait behind lost packets
+template<typename T>
+constexpr bool unordered_delivery = false;
+
+struct ReliableSettings
+{
+  //send fails with no_buffer_space when this many packets are not acknowledged,
+  //receiver drops packets this far ahead of first missing one
+  std::uint32_t window = 256;
+
+  //retransmission timeout before round trip is measured, and bounds of measured one
+  std::chrono::milliseconds initial_rto = std::chrono::milliseconds(100);
+  std::chrono::milliseconds min_rto = std::chrono::milliseconds(2);
+  std::chrono::milliseconds max_rto = std::chrono::seconds(2);
+
+  //packet is retransmitted without waiting for timeout after this many acknowledgements of later packets
+  unsigned fast_retransmit_threshold = 3;
+
+  //process fails with timed_out when packet is not acknowledged after this many retransmits
+  unsigned max_retransmits = 10;
+
+  //received packets are acknowledged after ack_every of them or after ack_delay,
+  //acknowledgement is piggybacked on outgoing packets and sent right away on gap
+  unsigned ack_every = 4;
+  std::chrono::milliseconds ack_delay = std::chrono::milliseconds(5);
+
+  //loss model for tests, outgoing datagram is dropped when it returns true
+  std::function<bool()> drop_outgoing;
+};
+
+namespace details
+{
+
+//Datagram header of ReliableChannel, integers in network byte order:
+//flags, alternative index of packet, sequence number of packet,
+//cumulative ack (all packets before it are received), selective ack (bit i: packet ack+1+i is received)
+struct reliable_header
+{
+  static constexpr std::size_t size = 16;
+
+  static constexpr std::uint8_t has_packet = 1;
+
+  std::uint8_t flags = 0;
+  std::uint8_t tag = 0;
+  std::uint32_t seq = 0;
+  std::uint32_t ack = 0;
+  std::uint32_t sack = 0;
+
+  static void put_u32(std::byte* p, std::uint32_t v) noexcept
+  {
+    for(unsigned i = 0; i != 4; ++i) p[i] = static_cast<std::byte>(v >> (8 * (3 - i)));
+  }
+
+  static std::uint32_t get_u32(const std::byte* p) noexcept
+  {
+    std::uint32_t v = 0;
+    for(unsigned i = 0; i != 4; ++i) v = v << 8 | std::to_integer<std::uint32_t>(p[i]);
+
+    return v;
+  }
+
+  void encode(std::byte (&out)[size]) const noexcept
+  {
+    out[0] = std::byte{flags};
+    out[1] = std::byte{tag};
+    out[2] = out[3] = std::byte{0};
+    put_u32(out + 4, seq);
+    put_u32(out + 8, ack);
+    put_u32(out + 12, sack);
+  }
+
+  static reliable_header decode(const std::byte* in) noexcept
+  {
+    return {
+      std::to_integer<std::uint8_t>(in[0]), std::to_integer<std::uint8_t>(in[1]),
+      get_u32(in + 4), get_u32(in + 8), get_u32(in + 12)};
+  }
+};
+
+//sequence numbers wrap around, a is before b when b is less than half of sequence space ahead
+constexpr bool seq_before(std::uint32_t a, std::uint32_t b) noexcept
+{
+  return static_cast<std::int32_t>(a - b) < 0;
+}
+
+} //namespace details
+
+//Reliable datagram channel over connected datagram socket, between lossy datagrams and streams.
+//Packets (alternatives of V) are numbered, every datagram carries cumulative and selective acknowledgement
+//of received ones, so loss of one packet does not stall acknowledgement of others.
+//Lost packets are retransmitted on timeout (measured round trip, exponential backoff) or right away
+//when later packets are acknowledged. Packets are delivered in send order, except types with unordered_delivery.
+//Both ends must use channel with same V; process must be called regularly, it also sends acks and retransmits.
+//Not thread safe, socket must outlive channel and must not be used directly meanwhile.
+template<SocketInfo SI, InvInfo INV, ConnectionSettings SCS, packet_variant_type V>
+  requires (SI.type == SocketType::Datagram && INV.connected)
+class ReliableChannel
+{
+  static_assert(raw_unchecked_settings<SCS>, "only raw wire encoding without checksum is supported");
+  static_assert(std::variant_size_v<V> <= 256);
+
+  using clock = std::chrono::steady_clock;
+  using header = details::reliable_header;
+
+  struct outgoing
+  {
+    V packet;
+    clock::time_point sent_at;
+    clock::time_point retransmit_at;
+    unsigned retransmits = 0;
+    unsigned later_acked = 0;
+    bool acked = false;
+  };
+
+  struct incoming
+  {
+    V packet;
+    bool delivered;
+  };
+
+  static constexpr std::size_t max_packet_size = []<std::size_t... Is>(std::index_sequence<Is...>)
+  {
+    return (std::max)({sizeof(std::variant_alternative_t<Is, V>)...});
+  }(std::make_index_sequence<std::variant_size_v<V>>{});
+
+  static constexpr sys_errc::ErrorCode invalid_argument_err = sys_errc::common::sockets::invalid_argument;
+  static constexpr sys_errc::ErrorCode no_buffer_space_err  = sys_errc::common::sockets::no_buffer_space;
+  static constexpr sys_errc::ErrorCode timed_out_err        = sys_errc::common::sockets::timed_out;
+
+  Socket<SI, INV, SCS>& m_sock_;
+  ReliableSettings m_settings_;
+
+  //send window: packets from m_send_base_ to m_next_seq_ at index seq % window
+  std::vector<std::optional<outgoing>> m_sent_;
+  std::uint32_t m_send_base_ = 0;
+  std::uint32_t m_next_seq_ = 0;
+
+  //receive window: packets after m_recv_next_ which arrived before it
+  std::vector<std::optional<incoming>> m_received_;
+  std::uint32_t m_recv_next_ = 0;
+
+  unsigned m_unacked_received_ = 0;
+  std::optional<clock::time_point> m_ack_due_;
+
+  std::optional<clock::duration> m_srtt_;
+  clock::duration m_rttvar_{};
+  clock::duration m_rto_;
+
+  std::byte m_rx_[header::size + max_packet_size + 1];
+
+  std::uint32_t in_flight_count() const noexcept { return m_next_seq_ - m_send_base_; }
+
+  template<typename T>
+  T convert(T t) const noexcept
+  {
+    if(m_sock_.converts_byte_order())
+      details::convert_byte_order(t);
+
+    return t;
+  }
+
+  std::uint32_t selective_ack() const noexcept
+  {
+    std::uint32_t sack = 0;
+    const std::uint32_t n = (std::min)(m_settings_.window - 1, std::uint32_t(32));
+
+    for(std::uint32_t i = 0; i != n; ++i)
+      if(m_received_[(m_recv_next_ + 1 + i) % m_settings_.window]) sack |= std::uint32_t(1) << i;
+
+    return sack;
+  }
+
+  //sends packet with sequence number seq or pure ack when packet is null, returns false on error
+  bool transmit(std::uint32_t seq, const V* packet) noexcept
+  {
+    header h{ .seq = seq, .ack = m_recv_next_, .sack = selective_ack() };
+
+    //acknowledgement goes with any datagram
+    m_unacked_received_ = 0;
+    m_ack_due_.reset();
+
+    if(m_settings_.drop_outgoing && m_settings_.drop_outgoing()) return true;
+
+    std::byte hdr[header::size];
+    details::const_buffer bufs[2] = {{hdr, header::size}, {nullptr, 0}};
+
+    if(packet)
+    {
+      h.flags = header::has_packet;
+      h.tag = static_cast<std::uint8_t>(packet->index());
+      bufs[1] = std::visit([](const auto& p) { return details::const_buffer{&p, sizeof(p)}; }, *packet);
+    }
+
+    h.encode(hdr);
+
+    //refusal reported for earlier datagram while peer is not listening yet, packet counts as lost
+    return
+      details::send_gathered_datagram(details::socket_access::handle(m_sock_), bufs, packet ? 2 : 1, nullptr, 0) ||
+      details::last_error_refused();
+  }
+
+  void sample_rtt(clock::duration r) noexcept
+  {
+    //RFC 6298
+    if(!m_srtt_)
+    {
+      m_srtt_ = r;
+      m_rttvar_ = r / 2;
+    }
+    else
+    {
+      const auto diff = *m_srtt_ > r ? *m_srtt_ - r : r - *m_srtt_;
+      m_rttvar_ = (3 * m_rttvar_ + diff) / 4;
+      m_srtt_ = (7 * *m_srtt_ + r) / 8;
+    }
+
+    m_rto_ = std::clamp<clock::duration>(*m_srtt_ + 4 * m_rttvar_, m_settings_.min_rto, m_settings_.max_rto);
+  }
+
+  void mark_acked(std::uint32_t seq, clock::time_point now) noexcept
+  {
+    auto& o = m_sent_[seq % m_settings_.window];
+    if(!o || o->acked) return;
+
+    //round trip of retransmitted packet is ambiguous (Karn)
+    if(o->retransmits == 0) sample_rtt(now - o->sent_at);
+
+    o->acked = true;
+  }
+
+  void on_ack(std::uint32_t ack, std::uint32_t sack, clock::time_point now) noexcept
+  {
+    //ack outside of window is stale or forged
+    if(ack - m_send_base_ > in_flight_count()) return;
+
+    for(std::uint32_t s = m_send_base_; s != ack; ++s) mark_acked(s, now);
+
+    std::optional<std::uint32_t> highest;
+    for(std::uint32_t i = 0; i != 32; ++i)
+    {
+      const std::uint32_t s = ack + 1 + i;
+      if(!(sack >> i & 1) || !details::seq_before(s, m_next_seq_)) continue;
+
+      mark_acked(s, now);
+      highest = s;
+    }
+
+    while(m_send_base_ != m_next_seq_ && m_sent_[m_send_base_ % m_settings_.window]->acked)
+      m_sent_[m_send_base_++ % m_settings_.window].reset();
+
+    if(!highest) return;
+
+    //fast retransmit of packets missing below acknowledged ones, once per packet,
+    //duplicates it causes are acknowledged too and would trigger it again
+    for(std::uint32_t s = m_send_base_; details::seq_before(s, *highest); ++s)
+    {
+      auto& o = m_sent_[s % m_settings_.window];
+      if(o->acked || o->retransmits != 0 || ++o->later_acked != m_settings_.fast_retransmit_threshold) continue;
+
+      o->retransmit_at = now;
+    }
+  }
+
+  //stores received packet, returns false when it was already received or is out of window
+  bool store(std::uint32_t seq, V&& packet) noexcept
+  {
+    if(details::seq_before(seq, m_recv_next_) || seq - m_recv_next_ >= m_settings_.window) return false;
+
+    auto& slot = m_received_[seq % m_settings_.window];
+    if(slot) return false;
+
+    slot.emplace(incoming{std::move(packet), false});
+
+    return true;
+  }
+
+  template<typename OnPacket>
+  std::size_t deliver(std::uint32_t seq, OnPacket& on_packet)
+  {
+    std::size_t delivered = 0;
+
+    auto& slot = *m_received_[seq % m_settings_.window];
+    if(std::visit([](const auto& p) { return unordered_delivery<std::decay_t<decltype(p)>>; }, slot.packet))
+    {
+      slot.delivered = true;
+      ++delivered;
+      on_packet(std::bit_cast<valid_packet_variant<V>>(slot.packet));
+    }
+
+    for(auto* s = &m_received_[m_recv_next_ % m_settings_.window]; *s; s = &m_received_[m_recv_next_ % m_settings_.window])
+    {
+      const incoming in = std::move(**s);
+      s->reset();
+      ++m_recv_next_;
+
+      if(in.delivered) continue;
+
+      ++delivered;
+      on_packet(std::bit_cast<valid_packet_variant<V>>(in.packet));
+    }
+
+    return delivered;
+  }
+
+  //decodes packet of datagram, returns nullopt for malformed or invalid one
+  std::optional<V> decode_packet(const header& h, const std::byte* data, std::size_t size) const noexcept
+  {
+    std::optional<V> res;
+
+    if(h.tag >= std::variant_size_v<V>) return res;
+
+    [&]<std::size_t... Is>(std::index_sequence<Is...>)
+    {
+      (void)((Is == h.tag && [&]
+      {
+        using T = std::variant_alternative_t<Is, V>;
+
+        if(size != sizeof(T)) return true;
+
+        T t;
+        std::memcpy(&t, data, sizeof(T));
+        t = convert(t);
+
+        if(t.is_valid()) res.emplace(std::in_place_index<Is>, t);
+
+        return true;
+      }()) || ...);
+    }(std::make_index_sequence<std::variant_size_v<V>>{});
+
+    return res;
+  }
+
+  //reads one datagram, returns number of delivered packets or -1 on error
+  template<typename OnPacket>
+  std::ptrdiff_t read(OnPacket& on_packet, clock::time_point now)
+  {
+    auto r = ::recv(details::socket_access::handle(m_sock_), reinterpret_cast<char*>(m_rx_), sizeof(m_rx_), 0);
+
+    //refusal of earlier datagram is reported on receive, it was lost
+    if(r < 0) return details::last_error_refused() ? 0 : -1;
+
+    //malformed datagrams are dropped like lost ones
+    if(static_cast<std::size_t>(r) < header::size) return 0;
+
+    const header h = header::decode(m_rx_);
+
+    on_ack(h.ack, h.sack, now);
+
+    if(!(h.flags & header::has_packet)) return 0;
+
+    auto packet = decode_packet(h, m_rx_ + header::size, static_cast<std::size_t>(r) - header::size);
+    if(!packet) return 0;
+
+    const bool in_order = h.seq == m_recv_next_;
+
+    if(!store(h.seq, std::move(*packet)))
+    {
+      //duplicate means our ack was lost
+      m_ack_due_ = now;
+      return 0;
+    }
+
+    //gap is reported right away to trigger fast retransmit
+    if(!in_order)
+      m_ack_due_ = now;
+    else if(++m_unacked_received_ >= m_settings_.ack_every)
+      m_ack_due_ = now;
+    else if(!m_ack_due_)
+      m_ack_due_ = now + m_settings_.ack_delay;
+
+    return static_cast<std::ptrdiff_t>(deliver(h.seq, on_packet));
+  }
+
+  //sends due acks and retransmits, returns time of next timer or nullopt when packet ran out of retransmits
+  std::optional<clock::time_point> run_timers(clock::time_point now, sys_errc::ErrorCode& err) noexcept
+  {
+    auto next = clock::time_point::max();
+
+    for(std::uint32_t s = m_send_base_; s != m_next_seq_; ++s)
+    {
+      auto& o = *m_sent_[s % m_settings_.window];
+      if(o.acked) continue;
+
+      if(now >= o.retransmit_at)
+      {
+        if(o.retransmits == m_settings_.max_retransmits)
+        {
+          err = timed_out_err;
+          return std::nullopt;
+        }
+
+        //failed retransmit is same as lost one
+        transmit(s, &o.packet);
+
+        ++o.retransmits;
+        o.retransmit_at = now + (std::min)(m_rto_ * (clock::duration::rep(1) << (std::min)(o.retransmits, 16u)), clock::duration(m_settings_.max_rto));
+      }
+
+      next = (std::min)(next, o.retransmit_at);
+    }
+
+    if(m_ack_due_ && now >= *m_ack_due_) transmit(0, nullptr);
+    if(m_ack_due_) next = (std::min)(next, *m_ack_due_);
+
+    return next;
+  }
+
+public:
+  ReliableChannel(Socket<SI, INV, SCS>& sock, const ReliableSettings& settings = {}) :
+    m_sock_(sock),
+    m_settings_(settings),
+    m_sent_(settings.window),
+    m_received_(settings.window),
+    m_rto_(settings.initial_rto) {}
+
+  ReliableChannel(const ReliableChannel&) = delete;
+  ReliableChannel& operator=(const ReliableChannel&) = delete;
+
+  //sent packets not acknowledged yet
+  std::size_t in_flight() const noexcept { return in_flight_count(); }
+
+  //Sends packet, fails with no_buffer_space when window is full
+  template<auto EHP = ehl::Policy::Exception, packet_type T>
+  [[nodiscard]] ehl::Result_t<void, sys_errc::ErrorCode, EHP> send(const valid_packet<T>& t)
+    noexcept(EHP != ehl::Policy::Exception)
+  {
+    EHL_THROW_IF(in_flight_count() >= m_settings_.window, no_buffer_space_err);
+
+    const auto now = clock::now();
+    const std::uint32_t seq = m_next_seq_;
+
+    auto& slot = m_sent_[seq % m_settings_.window];
+    slot.emplace(outgoing{ .packet = V(convert<T>(t)), .sent_at = now, .retransmit_at = now + m_rto_ });
+
+    if(!transmit(seq, &slot->packet))
+    {
+      slot.reset();
+      EHL_THROW_IF(true, sys_errc::last_error());
+    }
+
+    ++m_next_seq_;
+  }
+
+  template<auto EHP = ehl::Policy::Exception, packet_type T>
+  [[nodiscard]] ehl::Result_t<void, sys_errc::ErrorCode, EHP> send(const T& t)
+    noexcept(EHP != ehl::Policy::Exception)
+  {
+    EHL_THROW_IF(!t.is_valid(), invalid_argument_err);
+
+    return send<EHP, T>(std::bit_cast<valid_packet<T>>(t));
+  }
+
+  //Waits up to timeout_ms (-1 is infinite) for packets, calls on_packet(valid_packet_variant<V>) for each
+  //delivered one, meanwhile acknowledges received and retransmits lost packets.
+  //Returns number of delivered packets, fails with timed_out when peer does not acknowledge packet
+  template<auto EHP = ehl::Policy::Exception, typename OnPacket>
+  [[nodiscard]] ehl::Result_t<std::size_t, sys_errc::ErrorCode, EHP> process(int timeout_ms, OnPacket&& on_packet)
+    noexcept(EHP != ehl::Policy::Exception)
+  {
+    const auto until = timeout_ms < 0 ? clock::time_point::max() : clock::now() + std::chrono::milliseconds(timeout_ms);
+    std::size_t delivered = 0;
+    bool polled = false;
+
+    for(;;)
+    {
+      auto now = clock::now();
+
+      sys_errc::ErrorCode err = timed_out_err;
+      const auto next_timer = run_timers(now, err);
+
+      EHL_THROW_IF(!next_timer, err);
+
+      //socket is polled at least once, so expired timeout still takes queued packets
+      if(polled && (delivered != 0 || now >= until)) break;
+
+      const auto wake = (std::min)(until, *next_timer);
+      const auto wait = wake <= now ? 0 : (std::min)(
+        std::chrono::ceil<std::chrono::milliseconds>(wake - now).count(),
+        static_cast<std::chrono::milliseconds::rep>(std::numeric_limits<int>::max()));
+
+      pollfd fd{ .fd = details::socket_access::handle(m_sock_), .events = std::to_underlying(PollFlags::In), .revents = 0 };
+      int r = HPP_IFE(HPP_WIN_IMPL)(::WSAPoll)(::poll)(&fd, 1, static_cast<int>(wait));
+
+      polled = true;
+
+      //queued datagrams are drained before timers run again
+      while(r > 0)
+      {
+        const auto n = read(on_packet, clock::now());
+
+        EHL_THROW_IF(n < 0, sys_errc::last_error());
+
+        delivered += static_cast<std::size_t>(n);
+
+        r = HPP_IFE(HPP_WIN_IMPL)(::WSAPoll)(::poll)(&fd, 1, 0);
+      }
+
+      EHL_THROW_IF(r < 0, sys_errc::last_error());
+    }
+
+    return delivered;
+  }
+};
+
+//ReliableChannel carrying alternatives of V, e.g. make_reliable_channel<std::variant<Order, Cancel>>(sock)
+template<packet_variant_type V, SocketInfo SI, InvInfo INV, ConnectionSettings SCS>
+ReliableChannel<SI, INV, SCS, V> make_reliable_channel(Socket<SI, INV, SCS>& sock, const ReliableSettings& settings = {})
+{
+  return ReliableChannel<SI, INV, SCS, V>(sock, settings);
+}
+
+} //namespace cpps
@@ -0,0 +1,279 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <variant>
+#include "socket.hpp"
+#include "details/batch_io.hpp"
+#include "details/cpu_relax.hpp"
+#include "details/socket_access.hpp"
+
+namespace cpps
+{
+
+//Socket wrapper for sending from many threads at once.
+//Uses flat combining: callers publish requests into lock-free list,
+//one of them becomes combiner and sends all pending requests with single sendmmsg/gathered write,
+//so contention turns into batching instead of convoying on mutex.
+//Socket must outlive SharedSender and must not be used for sending directly meanwhile.
+template<SocketInfo SI, InvInfo INV, ConnectionSettings SCS>
+class SharedSender
+{
+  static_assert(raw_unchecked_settings<SCS>, "only raw wire encoding without checksum is supported");
+
+  struct request
+  {
+    details::const_buffer buffer;
+    const Address<SI.address_family>* addr;
+    request* next = nullptr;
+    std::optional<sys_errc::ErrorCode> error = std::nullopt;
+    std::atomic<bool> done = false;
+  };
+
+  static constexpr unsigned spin_count = 128;
+
+  Socket<SI, INV, SCS>& m_sock_;
+  std::atomic<request*> m_head_ = nullptr;
+  std::atomic_flag m_combining_;
+  //bumped after each drain, sleeping callers wait on it instead of on their request,
+  //which may be destroyed as soon as it is completed
+  std::atomic<std::uint32_t> m_generation_ = 0;
+
+  template<ConnectionSettings CS, packet_type T>
+  static constexpr T convert_byte_order(T t) noexcept
+  {
+    if constexpr(CS.convert_byte_order)
+      details::convert_byte_order(t);
+
+    return t;
+  }
+
+  template<packet_variant_type V>
+  static details::const_buffer convert_variant(V& v, bool convert) noexcept
+  {
+    return std::visit([convert](auto& p)
+    {
+      if(convert) details::convert_byte_order(p);
+      return details::const_buffer{&p, sizeof(p)};
+    }, v);
+  }
+
+  static void complete(request* r, std::optional<sys_errc::ErrorCode> err) noexcept
+  {
+    r->error = err;
+
+    //request lives on waiting thread stack, it must not be touched after done is set
+    r->done.store(true, std::memory_order_release);
+  }
+
+  void send_batch(request** batch, unsigned count) noexcept
+  {
+    const auto h = details::socket_access::handle(m_sock_);
+
+    if constexpr(SI.type == SocketType::Stream)
+    {
+      details::const_buffer bufs[details::max_batch_size];
+      for(unsigned i = 0; i != count; ++i) bufs[i] = batch[i]->buffer;
+
+      //stream state is unknown after failed write, so whole batch fails
+      std::optional<sys_errc::ErrorCode> err;
+      if(!details::send_all(h, bufs, count)) err = sys_errc::last_error();
+
+      for(unsigned i = 0; i != count; ++i) complete(batch[i], err);
+    }
+    else
+    {
+      details::outgoing_datagram dgrams[details::max_batch_size];
+      for(unsigned i = 0; i != count; ++i)
+      {
+        dgrams[i].buffer  = batch[i]->buffer;
+        dgrams[i].addr    = batch[i]->addr ? details::to_sockaddr_ptr(batch[i]->addr) : nullptr;
+        dgrams[i].addrlen = batch[i]->addr ? details::sockaddr_length(*batch[i]->addr) : 0;
+      }
+
+      unsigned i = 0;
+      while(i != count)
+      {
+        int r = details::send_datagrams(h, dgrams + i, count - i);
+
+        //first datagram failed, report it and continue with others
+        if(r < 0)
+        {
+          complete(batch[i++], sys_errc::last_error());
+          continue;
+        }
+
+        for(int j = 0; j != r; ++j) complete(batch[i++], std::nullopt);
+      }
+    }
+  }
+
+  void drain() noexcept
+  {
+    while(request* list = m_head_.exchange(nullptr))
+    {
+      //list is LIFO, reverse to keep per thread order and approximate arrival order
+      request* fifo = nullptr;
+      while(list) fifo = std::exchange(list, std::exchange(list->next, fifo));
+
+      request* batch[details::max_batch_size];
+      unsigned count = 0;
+
+      while(fifo)
+      {
+        //next must be read before completion, completed request can be destroyed
+        batch[count++] = std::exchange(fifo, fifo->next);
+
+        if(count == details::max_batch_size || !fifo)
+        {
+          send_batch(batch, count);
+          count = 0;
+        }
+      }
+    }
+
+    m_generation_.fetch_add(1, std::memory_order_release);
+    m_generation_.notify_all();
+  }
+
+  void submit(request& r) noexcept
+  {
+    r.next = m_head_.load(std::memory_order_relaxed);
+    while(!m_head_.compare_exchange_weak(r.next, &r));
+
+    for(unsigned spins = 0; !r.done.load(std::memory_order_acquire); ++spins)
+    {
+      if(!m_combining_.test_and_set())
+      {
+        //request published after drain but before clear could be missed by other threads
+        //which observed combiner lock taken, so recheck list after releasing lock
+        do
+        {
+          drain();
+          m_combining_.clear();
+        }
+        while(m_head_.load() != nullptr && !m_combining_.test_and_set());
+
+        continue;
+      }
+
+      //combiner is active and will process this request, spin shortly then sleep
+      if(spins < spin_count)
+      {
+        details::cpu_relax();
+        continue;
+      }
+
+      //generation is read before done, so completion after this check changes generation and ends wait
+      const auto generation = m_generation_.load(std::memory_order_acquire);
+
+      if(!r.done.load(std::memory_order_acquire))
+        m_generation_.wait(generation, std::memory_order_acquire);
+    }
+  }
+
+  template<auto EHP>
+  ehl::Result_t<void, sys_errc::ErrorCode, EHP> submit_buffer(
+    details::const_buffer buffer, const Address<SI.address_family>* addr)
+      noexcept(EHP != ehl::Policy::Exception)
+  {
+    request r{ .buffer = buffer, .addr = addr };
+
+    submit(r);
+
+    EHL_THROW_IF(r.error.has_value(), *r.error);
+  }
+
+  static constexpr sys_errc::ErrorCode invalid_argument_err = sys_errc::common::sockets::invalid_argument;
+
+public:
+  explicit SharedSender(Socket<SI, INV, SCS>& sock) noexcept : m_sock_(sock) {}
+
+  SharedSender(const SharedSender&) = delete;
+  SharedSender& operator=(const SharedSender&) = delete;
+
+  template<auto EHP = ehl::Policy::Exception, packet_type T> requires (INV.connected)
+  [[nodiscard]] ehl::Result_t<void, sys_errc::ErrorCode, EHP> send(const valid_packet<T>& t)
+    noexcept(EHP != ehl::Policy::Exception)
+  {
+    T t_copy = t;
+    if(m_sock_.converts_byte_order())
+      details::convert_byte_order(t_copy);
+
+    return submit_buffer<EHP>({&t_copy, sizeof(T)}, nullptr);
+  }
+
+  template<auto EHP = ehl::Policy::Exception, packet_type T> requires (INV.connected)
+  [[nodiscard]] ehl::Result_t<void, sys_errc::ErrorCode, EHP> send(const T& t)
+    noexcept(EHP != ehl::Policy::Exception)
+  {
+    EHL_THROW_IF(!t.is_valid(), invalid_argument_err);
+
+    return send<EHP, T>(std::bit_cast<valid_packet<T>>(t));
+  }
+
+  template<auto EHP = ehl::Policy::Exception, packet_variant_type V> requires (INV.connected && SI.type != SocketType::Stream)
+  [[nodiscard]] ehl::Result_t<void, sys_errc::ErrorCode, EHP> send(const valid_packet_variant<V>& v)
+    noexcept(EHP != ehl::Policy::Exception)
+  {
+    V v_copy = v;
+
+    return submit_buffer<EHP>(convert_variant(v_copy, m_sock_.converts_byte_order()), nullptr);
+  }
+
+  template<auto EHP = ehl::Policy::Exception, packet_variant_type V> requires (INV.connected && SI.type != SocketType::Stream)
+  [[nodiscard]] ehl::Result_t<void, sys_errc::ErrorCode, EHP> send(const V& v)
+    noexcept(EHP != ehl::Policy::Exception)
+  {
+    EHL_THROW_IF(!packet_variant_validate_predicate<V>(v), invalid_argument_err);
+
+    return send<EHP, V>(std::bit_cast<valid_packet_variant<V>>(v));
+  }
+
+  template<ConnectionSettings CS = default_connection_settings, auto EHP = ehl::Policy::Exception, packet_type T>
+    requires (SI.type == SocketType::Datagram && raw_unchecked_settings<CS>)
+  [[nodiscard]] ehl::Result_t<void, sys_errc::ErrorCode, EHP> sendto(
+    const valid_packet<T>& t, const Address<SI.address_family>& addr)
+      noexcept(EHP != ehl::Policy::Exception)
+  {
+    T t_copy = convert_byte_order<CS, T>(t);
+
+    return submit_buffer<EHP>({&t_copy, sizeof(T)}, &addr);
+  }
+
+  template<ConnectionSettings CS = default_connection_settings, auto EHP = ehl::Policy::Exception, packet_type T>
+    requires (SI.type == SocketType::Datagram && raw_unchecked_settings<CS>)
+  [[nodiscard]] ehl::Result_t<void, sys_errc::ErrorCode, EHP> sendto(const T& t, const Address<SI.address_family>& addr)
+      noexcept(EHP != ehl::Policy::Exception)
+  {
+    EHL_THROW_IF(!t.is_valid(), invalid_argument_err);
+
+    return sendto<CS, EHP, T>(std::bit_cast<valid_packet<T>>(t), addr);
+  }
+
+  template<ConnectionSettings CS = default_connection_settings, auto EHP = ehl::Policy::Exception, packet_variant_type V>
+    requires (SI.type == SocketType::Datagram && raw_unchecked_settings<CS>)
+  [[nodiscard]] ehl::Result_t<void, sys_errc::ErrorCode, EHP> sendto(
+    const valid_packet_variant<V>& v, const Address<SI.address_family>& addr)
+      noexcept(EHP != ehl::Policy::Exception)
+  {
+    V v_copy = v;
+
+    return submit_buffer<EHP>(convert_variant(v_copy, CS.convert_byte_order), &addr);
+  }
+
+  template<ConnectionSettings CS = default_connection_settings, auto EHP = ehl::Policy::Exception, packet_variant_type V>
+    requires (SI.type == SocketType::Datagram && raw_unchecked_settings<CS>)
+  [[nodiscard]] ehl::Result_t<void, sys_errc::ErrorCode, EHP> sendto(
+    const V& v, const Address<SI.address_family>& addr)
+      noexcept(EHP != ehl::Policy::Exception)
+  {
+    EHL_THROW_IF(!packet_variant_validate_predicate<V>(v), invalid_argument_err);
+
+    return sendto<CS, EHP, V>(std::bit_cast<valid_packet_variant<V>>(v), addr);
+  }
+};
+
+} //namespace cpps
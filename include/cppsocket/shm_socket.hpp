@@ -0,0 +1,515 @@
+#pragma once
+
+#include "details/platform_headers.hpp"
+
+#if HPP_POSIX_IMPL
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <optional>
+#include <string>
+#include <utility>
+#include <variant>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "socket.hpp"
+#include "details/cpu_relax.hpp"
+#include "details/futex.hpp"
+#include "details/spsc_queue.hpp"
+
+namespace cpps
+{
+
+namespace details
+{
+
+//one direction of shared memory channel, lives in shared mapping
+struct shm_ring
+{
+  alignas(cache_line_size) std::atomic<std::uint64_t> head;
+  std::atomic<std::uint32_t> data_seq;
+  std::atomic<std::uint32_t> consumer_waiting;
+
+  alignas(cache_line_size) std::atomic<std::uint64_t> tail;
+  std::atomic<std::uint32_t> space_seq;
+  std::atomic<std::uint32_t> producer_waiting;
+};
+
+struct shm_header
+{
+  static constexpr std::uint64_t magic_value = 0x6370707373686d31; //"cppsshm1"
+
+  std::atomic<std::uint64_t> magic;
+  std::uint64_t capacity;
+  std::atomic<std::uint32_t> closed[2];
+
+  shm_ring rings[2];
+};
+
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free);
+
+//message record in ring: 8 byte header followed by payload, padded to 8 bytes
+struct shm_record_header
+{
+  static constexpr std::uint32_t wrap_marker = 0xFFFFFFFF;
+
+  std::uint32_t size;
+  std::uint32_t reserved;
+};
+
+constexpr std::size_t shm_record_size(std::size_t payload) noexcept
+{
+  return (sizeof(shm_record_header) + payload + 7) & ~std::size_t{7};
+}
+
+} //namespace details
+
+//Same host transport over shared memory with the same send/recv surface as connected Socket.
+//Two SPSC byte rings (one per direction) live in POSIX shared memory object or memfd,
+//peers spin shortly and then sleep on futex, so hop costs one copy in and one copy out without syscalls.
+//Each endpoint may be used by one sending and one receiving thread at a time.
+template<ConnectionSettings SCS = local_connection_settings>
+class ShmSocket
+{
+  static_assert(raw_unchecked_settings<SCS>, "only raw wire encoding without checksum is supported");
+  static_assert(!SCS.negotiate_byte_order, "shared memory peers share byte order, use local_connection_settings");
+
+  static constexpr unsigned spin_count = 1024;
+
+  details::shm_header* m_header_ = nullptr;
+  std::size_t m_mapping_size_ = 0;
+  unsigned m_side_ = 0;
+  int m_fd_ = -1;
+  std::string m_name_;
+
+  ShmSocket(details::shm_header* header, std::size_t mapping_size, unsigned side, int fd, std::string name) noexcept :
+    m_header_(header), m_mapping_size_(mapping_size), m_side_(side), m_fd_(fd), m_name_(std::move(name)) {}
+
+  static constexpr sys_errc::ErrorCode not_connected_err       = sys_errc::common::sockets::not_connected;
+  static constexpr sys_errc::ErrorCode wrong_protocol_type_err = sys_errc::common::sockets::wrong_protocol_type;
+  static constexpr sys_errc::ErrorCode invalid_argument_err    = sys_errc::common::sockets::invalid_argument;
+
+  template<packet_type T>
+  static constexpr T convert_byte_order(T t) noexcept
+  {
+    if constexpr(SCS.convert_byte_order)
+      details::convert_byte_order(t);
+
+    return t;
+  }
+
+  template<typename V>
+  struct variant_storage;
+
+  template<typename... Ts>
+  struct variant_storage<std::variant<Ts...>>
+  {
+    alignas(Ts...) std::byte data[(std::max)({sizeof(Ts)...})];
+  };
+
+  static std::size_t mapping_size(std::size_t capacity) noexcept
+  {
+    return sizeof(details::shm_header) + 2 * capacity;
+  }
+
+  std::byte* ring_data(unsigned ring) const noexcept
+  {
+    return reinterpret_cast<std::byte*>(m_header_ + 1) + ring * m_header_->capacity;
+  }
+
+  details::shm_ring& tx() const noexcept { return m_header_->rings[m_side_]; }
+  details::shm_ring& rx() const noexcept { return m_header_->rings[1 - m_side_]; }
+
+  bool peer_closed() const noexcept
+  {
+    return m_header_->closed[1 - m_side_].load(std::memory_order_acquire) != 0;
+  }
+
+  static void wake(std::atomic<std::uint32_t>& waiting, std::atomic<std::uint32_t>& seq) noexcept
+  {
+    //pairs with fence in wait, either waiter sees new position or we see waiting flag
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    if(waiting.load(std::memory_order_relaxed) != 0)
+    {
+      waiting.store(0, std::memory_order_relaxed);
+      seq.fetch_add(1, std::memory_order_release);
+      details::futex_wake_all(seq);
+    }
+  }
+
+  //waits until ready() holds, returns false if peer closed channel meanwhile
+  template<typename F>
+  bool wait(std::atomic<std::uint32_t>& waiting, std::atomic<std::uint32_t>& seq, F ready) const noexcept
+  {
+    for(unsigned spins = 0; !ready(); ++spins)
+    {
+      if(peer_closed()) return ready();
+
+      if(spins < spin_count)
+      {
+        details::cpu_relax();
+        continue;
+      }
+
+      const auto s = seq.load(std::memory_order_acquire);
+      waiting.store(1, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+
+      if(!ready() && !peer_closed()) details::futex_wait(seq, s);
+    }
+
+    return true;
+  }
+
+  //record must fit in half of ring, so wrap skip never blocks forever
+  bool fits(std::size_t size) const noexcept
+  {
+    return details::shm_record_size(size) <= m_header_->capacity / 2;
+  }
+
+  //returns false if peer closed channel
+  bool write(const void* data, std::size_t size) noexcept
+  {
+    const std::uint64_t capacity = m_header_->capacity;
+    const std::size_t record = details::shm_record_size(size);
+
+    details::shm_ring& r = tx();
+    std::byte* data_begin = ring_data(m_side_);
+
+    std::uint64_t head = r.head.load(std::memory_order_relaxed);
+    const std::uint64_t offset = head & (capacity - 1);
+
+    //record never wraps, rest of ring is skipped instead
+    const std::uint64_t skip = capacity - offset < record ? capacity - offset : 0;
+
+    const bool has_space = wait(r.producer_waiting, r.space_seq, [&]
+    {
+      return capacity - (head - r.tail.load(std::memory_order_acquire)) >= skip + record;
+    });
+
+    if(!has_space || peer_closed()) return false;
+
+    if(skip != 0)
+    {
+      const details::shm_record_header marker{ .size = details::shm_record_header::wrap_marker, .reserved = 0 };
+      std::memcpy(data_begin + offset, &marker, sizeof(marker));
+      head += skip;
+    }
+
+    std::byte* p = data_begin + (head & (capacity - 1));
+    const details::shm_record_header hdr{ .size = static_cast<std::uint32_t>(size), .reserved = 0 };
+    std::memcpy(p, &hdr, sizeof(hdr));
+    std::memcpy(p + sizeof(hdr), data, size);
+
+    r.head.store(head + record, std::memory_order_release);
+
+    wake(r.consumer_waiting, r.data_seq);
+
+    return true;
+  }
+
+  //copies next message into buffer, returns message size, message larger than buffer is truncated;
+  //returns nullopt if peer closed channel and everything sent before close was read
+  std::optional<std::size_t> read(void* buffer, std::size_t buffer_size) noexcept
+  {
+    const std::uint64_t capacity = m_header_->capacity;
+    details::shm_ring& r = rx();
+    const std::byte* data_begin = ring_data(1 - m_side_);
+
+    std::uint64_t tail = r.tail.load(std::memory_order_relaxed);
+
+    for(;;)
+    {
+      const bool has_data = wait(r.consumer_waiting, r.data_seq, [&]
+      {
+        return r.head.load(std::memory_order_acquire) != tail;
+      });
+
+      if(!has_data) return std::nullopt;
+
+      const std::byte* p = data_begin + (tail & (capacity - 1));
+      details::shm_record_header hdr;
+      std::memcpy(&hdr, p, sizeof(hdr));
+
+      if(hdr.size == details::shm_record_header::wrap_marker)
+      {
+        tail += capacity - (tail & (capacity - 1));
+        r.tail.store(tail, std::memory_order_release);
+        continue;
+      }
+
+      std::memcpy(buffer, p + sizeof(hdr), (std::min)(std::size_t{hdr.size}, buffer_size));
+
+      r.tail.store(tail + details::shm_record_size(hdr.size), std::memory_order_release);
+
+      wake(r.producer_waiting, r.space_seq);
+
+      return hdr.size;
+    }
+  }
+
+  //closes descriptor on failure paths
+  struct fd_guard
+  {
+    int fd;
+
+    ~fd_guard() { if(fd >= 0) ::close(fd); }
+
+    int release() noexcept { return std::exchange(fd, -1); }
+  };
+
+  template<auto EHP>
+  static ehl::Result_t<ShmSocket, sys_errc::ErrorCode, EHP> create_on(int fd, std::size_t capacity, std::string name)
+    noexcept(EHP != ehl::Policy::Exception)
+  {
+    fd_guard guard{fd};
+
+    capacity = std::bit_ceil((std::max)(capacity, std::size_t{4096}));
+    const std::size_t size = mapping_size(capacity);
+
+    int r = ::ftruncate(fd, static_cast<off_t>(size));
+
+    EHL_THROW_IF(r != 0, sys_errc::last_error());
+
+    void* p = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+    EHL_THROW_IF(p == MAP_FAILED, sys_errc::last_error());
+
+    auto* header = ::new(p) details::shm_header{};
+    header->capacity = capacity;
+
+    //magic is published last, opener validates it before touching rings
+    header->magic.store(details::shm_header::magic_value, std::memory_order_release);
+
+    return ShmSocket(header, size, 0, guard.release(), std::move(name));
+  }
+
+  template<auto EHP>
+  static ehl::Result_t<ShmSocket, sys_errc::ErrorCode, EHP> open_on(int fd)
+    noexcept(EHP != ehl::Policy::Exception)
+  {
+    fd_guard guard{fd};
+
+    struct stat st;
+    int r = ::fstat(fd, &st);
+
+    EHL_THROW_IF(r != 0, sys_errc::last_error());
+    EHL_THROW_IF(static_cast<std::size_t>(st.st_size) < sizeof(details::shm_header), invalid_argument_err);
+
+    const auto size = static_cast<std::size_t>(st.st_size);
+    void* p = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+    EHL_THROW_IF(p == MAP_FAILED, sys_errc::last_error());
+
+    auto* header = static_cast<details::shm_header*>(p);
+    const bool valid =
+      header->magic.load(std::memory_order_acquire) == details::shm_header::magic_value &&
+      mapping_size(header->capacity) == size;
+
+    if(!valid) ::munmap(p, size);
+
+    EHL_THROW_IF(!valid, invalid_argument_err);
+
+    return ShmSocket(header, size, 1, guard.release(), {});
+  }
+
+public:
+  static constexpr ConnectionSettings connection_settings = SCS;
+
+  //creates named shared memory object (shm_open), name is removed when creator is destroyed
+  template<auto EHP = ehl::Policy::Exception>
+  [[nodiscard]] static ehl::Result_t<ShmSocket, sys_errc::ErrorCode, EHP> make(const char* name, std::size_t capacity)
+    noexcept(EHP != ehl::Policy::Exception)
+  {
+    int fd = ::shm_open(name, O_CREAT | O_EXCL | O_RDWR | O_CLOEXEC, 0600);
+
+    EHL_THROW_IF(fd < 0, sys_errc::last_error());
+
+    return create_on<EHP>(fd, capacity, name);
+  }
+
+  //connects to channel created by make
+  template<auto EHP = ehl::Policy::Exception>
+  [[nodiscard]] static ehl::Result_t<ShmSocket, sys_errc::ErrorCode, EHP> open(const char* name)
+    noexcept(EHP != ehl::Policy::Exception)
+  {
+    int fd = ::shm_open(name, O_RDWR | O_CLOEXEC, 0);
+
+    EHL_THROW_IF(fd < 0, sys_errc::last_error());
+
+    return open_on<EHP>(fd);
+  }
+
+#if defined(__linux__)
+  //creates anonymous channel, fd() is passed to peer via fork or SCM_RIGHTS and opened with from_fd
+  template<auto EHP = ehl::Policy::Exception>
+  [[nodiscard]] static ehl::Result_t<ShmSocket, sys_errc::ErrorCode, EHP> make_anonymous(std::size_t capacity)
+    noexcept(EHP != ehl::Policy::Exception)
+  {
+    int fd = ::memfd_create("cppsocket", MFD_CLOEXEC);
+
+    EHL_THROW_IF(fd < 0, sys_errc::last_error());
+
+    return create_on<EHP>(fd, capacity, {});
+  }
+#endif
+
+  //takes ownership of fd
+  template<auto EHP = ehl::Policy::Exception>
+  [[nodiscard]] static ehl::Result_t<ShmSocket, sys_errc::ErrorCode, EHP> from_fd(int fd)
+    noexcept(EHP != ehl::Policy::Exception)
+  {
+    return open_on<EHP>(fd);
+  }
+
+  ShmSocket(ShmSocket&& s) noexcept :
+    m_header_(std::exchange(s.m_header_, nullptr)),
+    m_mapping_size_(s.m_mapping_size_),
+    m_side_(s.m_side_),
+    m_fd_(std::exchange(s.m_fd_, -1)),
+    m_name_(std::move(s.m_name_)) {}
+
+  ShmSocket& operator=(ShmSocket&& s) noexcept
+  {
+    ShmSocket tmp(std::move(s));
+
+    std::swap(m_header_, tmp.m_header_);
+    std::swap(m_mapping_size_, tmp.m_mapping_size_);
+    std::swap(m_side_, tmp.m_side_);
+    std::swap(m_fd_, tmp.m_fd_);
+    std::swap(m_name_, tmp.m_name_);
+
+    return *this;
+  }
+
+  ~ShmSocket()
+  {
+    if(m_header_)
+    {
+      //wake peer blocked on this side so it can observe close
+      m_header_->closed[m_side_].store(1, std::memory_order_release);
+      for(auto& r : m_header_->rings)
+      {
+        r.data_seq.fetch_add(1, std::memory_order_release);
+        r.space_seq.fetch_add(1, std::memory_order_release);
+        details::futex_wake_all(r.data_seq);
+        details::futex_wake_all(r.space_seq);
+      }
+
+      ::munmap(m_header_, m_mapping_size_);
+    }
+
+    if(m_fd_ >= 0) ::close(m_fd_);
+    if(!m_name_.empty()) ::shm_unlink(m_name_.c_str());
+  }
+
+  int fd() const noexcept { return m_fd_; }
+
+  template<packet_type T, auto EHP = ehl::Policy::Exception>
+  [[nodiscard]] ehl::Result_t<valid_packet<T>, sys_errc::ErrorCode, EHP> recv() noexcept(EHP != ehl::Policy::Exception)
+  {
+    alignas(T) std::byte storage[sizeof(T)];
+
+    std::optional<std::size_t> size = read(storage, sizeof(storage));
+
+    EHL_THROW_IF(!size, not_connected_err);
+    EHL_THROW_IF(*size != sizeof(T), wrong_protocol_type_err);
+
+    T result = convert_byte_order(std::bit_cast<T>(storage));
+
+    EHL_THROW_IF(!result.is_valid(), wrong_protocol_type_err);
+
+    return std::bit_cast<valid_packet<T>>(result);
+  }
+
+  template<packet_variant_type V, auto EHP = ehl::Policy::Exception>
+  [[nodiscard]] ehl::Result_t<valid_packet_variant<V>, sys_errc::ErrorCode, EHP> recv() noexcept(EHP != ehl::Policy::Exception)
+  {
+    variant_storage<V> storage;
+
+    std::optional<std::size_t> size = read(storage.data, sizeof(storage.data));
+
+    EHL_THROW_IF(!size, not_connected_err);
+
+    const auto decode = [&]<typename T>()
+    {
+      T t;
+      std::memcpy(&t, storage.data, sizeof(T));
+      return convert_byte_order(t);
+    };
+
+    //same rule as datagram socket: exactly one alternative must match size and be valid
+    std::array<bool, std::variant_size_v<V>> v;
+    [&]<std::size_t... Is>(std::index_sequence<Is...>)
+    {
+      ((v[Is] =
+        *size == sizeof(std::variant_alternative_t<Is, V>) &&
+        decode.template operator()<std::variant_alternative_t<Is, V>>().is_valid()), ...);
+    }(std::make_index_sequence<std::variant_size_v<V>>{});
+
+    EHL_THROW_IF(std::ranges::count(v, true) != 1, wrong_protocol_type_err);
+
+    V res;
+    [&]<std::size_t... Is>(std::index_sequence<Is...>)
+    {
+      (void)((v[Is] && (res.template emplace<Is>(decode.template operator()<std::variant_alternative_t<Is, V>>()), true)) || ...);
+    }(std::make_index_sequence<std::variant_size_v<V>>{});
+
+    return std::bit_cast<valid_packet_variant<V>>(res);
+  }
+
+  template<auto EHP = ehl::Policy::Exception, packet_type T>
+  [[nodiscard]] ehl::Result_t<void, sys_errc::ErrorCode, EHP> send(const valid_packet<T>& t)
+    noexcept(EHP != ehl::Policy::Exception)
+  {
+    EHL_THROW_IF(!fits(sizeof(T)), invalid_argument_err);
+
+    T t_copy = convert_byte_order<T>(t);
+
+    EHL_THROW_IF(!write(&t_copy, sizeof(T)), not_connected_err);
+  }
+
+  template<auto EHP = ehl::Policy::Exception, packet_type T>
+  [[nodiscard]] ehl::Result_t<void, sys_errc::ErrorCode, EHP> send(const T& t)
+    noexcept(EHP != ehl::Policy::Exception)
+  {
+    EHL_THROW_IF(!t.is_valid(), invalid_argument_err);
+
+    return send<EHP, T>(std::bit_cast<valid_packet<T>>(t));
+  }
+
+  template<auto EHP = ehl::Policy::Exception, packet_variant_type V>
+  [[nodiscard]] ehl::Result_t<void, sys_errc::ErrorCode, EHP> send(const valid_packet_variant<V>& v)
+    noexcept(EHP != ehl::Policy::Exception)
+  {
+    V v_copy = v;
+    const auto [data, size] = std::visit([](auto& p)
+    {
+      p = convert_byte_order(p);
+      return std::pair<const void*, std::size_t>{&p, sizeof(p)};
+    }, v_copy);
+
+    EHL_THROW_IF(!fits(size), invalid_argument_err);
+    EHL_THROW_IF(!write(data, size), not_connected_err);
+  }
+
+  template<auto EHP = ehl::Policy::Exception, packet_variant_type V>
+  [[nodiscard]] ehl::Result_t<void, sys_errc::ErrorCode, EHP> send(const V& v)
+    noexcept(EHP != ehl::Policy::Exception)
+  {
+    EHL_THROW_IF(!packet_variant_validate_predicate<V>(v), invalid_argument_err);
+
+    return send<EHP, V>(std::bit_cast<valid_packet_variant<V>>(v));
+  }
+};
+
+} //namespace cpps
+
+#endif
@@ -5,13 +5,22 @@
 #include <utility>
 #include <algorithm>
 #include <array>
+#include <cstdint>
+#include <optional>
 #include <span>
 #include <ehl/ehl.hpp>
 #include <system_errc/system_errc.hpp>
 #include <strict_enum/strict_enum.hpp>
 #include "details/convert_byte_order.hpp"
+#include "details/batch_io.hpp"
+#include "details/byte_order_negotiation.hpp"
+#include "details/crc32c.hpp"
 #include "details/socket_resource.hpp"
+#include "details/var_packet_io.hpp"
+#include "details/wire_encoding.hpp"
+#include "lazy_packet.hpp"
 #include "packet.hpp"
+#include "var_packet.hpp"
 #include "address.hpp"
 
 namespace cpps
@@ -21,10 +30,12 @@ STRICT_ENUM(SocketType)
 (
   Stream = SOCK_STREAM,
   Datagram = SOCK_DGRAM,
+  SeqPacket = SOCK_SEQPACKET,
 );
 
 STRICT_ENUM(SocketProtocol)
 (
+  Default = 0,
   TCP = IPPROTO_TCP,
   UDP = IPPROTO_UDP,
 );
@@ -40,6 +51,8 @@ struct SocketInfo
   AddressFamily  address_family;
   SocketType     type;
   SocketProtocol protocol;
+  //IPv6 socket which also serves IPv4 peers as IPv4-mapped addresses (IPV6_V6ONLY=0)
+  bool           dual_stack = false;
 };
 
 constexpr SocketInfo SI_IPv4_TCP = { AddressFamily::IPv4, SocketType::Stream, SocketProtocol::TCP };
@@ -47,6 +60,13 @@ constexpr SocketInfo SI_IPv6_TCP = { AddressFamily::IPv6, SocketType::Stream, So
 constexpr SocketInfo SI_IPv4_UDP = { AddressFamily::IPv4, SocketType::Datagram, SocketProtocol::UDP };
 constexpr SocketInfo SI_IPv6_UDP = { AddressFamily::IPv6, SocketType::Datagram, SocketProtocol::UDP };
 
+constexpr SocketInfo SI_Dual_TCP = { AddressFamily::IPv6, SocketType::Stream, SocketProtocol::TCP, true };
+constexpr SocketInfo SI_Dual_UDP = { AddressFamily::IPv6, SocketType::Datagram, SocketProtocol::UDP, true };
+
+constexpr SocketInfo SI_Unix_Stream    = { AddressFamily::Unix, SocketType::Stream,    SocketProtocol::Default };
+constexpr SocketInfo SI_Unix_Datagram  = { AddressFamily::Unix, SocketType::Datagram,  SocketProtocol::Default };
+constexpr SocketInfo SI_Unix_SeqPacket = { AddressFamily::Unix, SocketType::SeqPacket, SocketProtocol::Default };
+
 struct InvInfo
 {
   bool binded;
@@ -60,16 +80,74 @@ constexpr InvInfo inv_connect      = { .binded = false, .listening = false, .con
 constexpr InvInfo inv_bind_connect = { .binded = true,  .listening = false, .connected = true };
 constexpr InvInfo inv_bind_listen  = { .binded = true,  .listening = true,  .connected = false };
 
+enum class WireEncoding
+{
+  //packet goes as its memory layout, byte order converted when convert_byte_order is set
+  Raw,
+  //integer fields go as LEB128 varints (signed ones zigzag encoded), floating point fields in network byte order;
+  //packet is prefixed by its encoded length on streams
+  Varint
+};
+
 struct ConnectionSettings
 {
   bool convert_byte_order;
+  WireEncoding encoding = WireEncoding::Raw;
+  //Varint encoding on streams only: integer fields are sent as difference to same field
+  //of previous packet of same type sent on connection
+  bool delta_encoding = false;
+  //Raw encoding on connection oriented sockets only: Net connect/accept exchange byte order
+  //and layout_fingerprint with peer, byte order is converted only when they differ
+  bool negotiate_byte_order = false;
+  std::uint64_t layout_fingerprint = 0;
+  //time peer hello must arrive within during negotiation, 0 waits without limit
+  unsigned hello_timeout_ms = 5000;
+  //Raw encoding on datagram sockets only: CRC32C trailer is appended to each packet,
+  //received packet with wrong checksum is rejected before byte order conversion and validation
+  bool checksum = false;
+
+  constexpr bool operator==(const ConnectionSettings&) const noexcept = default;
 };
 
 constexpr ConnectionSettings default_connection_settings = { .convert_byte_order = true };
 
+//for peers on same host (e.g. unix domain sockets), both ends share byte order
+constexpr ConnectionSettings local_connection_settings = { .convert_byte_order = false };
+
+//for bandwidth bound links carrying mostly small or slowly changing integers
+constexpr ConnectionSettings compact_connection_settings = { .convert_byte_order = true, .encoding = WireEncoding::Varint };
+constexpr ConnectionSettings delta_connection_settings =
+  { .convert_byte_order = true, .encoding = WireEncoding::Varint, .delta_encoding = true };
+
+//for fleets of mostly same endian hosts, fingerprint covers layouts of packets Ts sent on connection.
+//Handshake is done by accept and Net connect functions, they fail with timed_out when peer hello does not arrive
+//within hello_timeout_ms, so peer which connects and stays silent can not stall accepting thread for longer
+template<packet_type... Ts>
+constexpr ConnectionSettings negotiated_connection_settings =
+  { .convert_byte_order = true, .negotiate_byte_order = true, .layout_fingerprint = details::layout_fingerprint<Ts...>() };
+
+//for datagrams crossing lossy or shared links, integrity is checked by checksum instead of is_valid alone
+constexpr ConnectionSettings checked_connection_settings = { .convert_byte_order = true, .checksum = true };
+
+//packets keep in memory layout on wire: needed by lazy packets and batch receive
+template<ConnectionSettings CS>
+concept raw_settings = CS.encoding == WireEncoding::Raw;
+
+//packets keep in memory layout on wire and have no checksum trailer: needed by packet variants, var_packet
+//and components writing packets to wire themselves
+template<ConnectionSettings CS>
+concept raw_unchecked_settings = raw_settings<CS> && !CS.checksum;
+
 template<SocketInfo SI, InvInfo INV, ConnectionSettings CS>
 class Socket;
 
+namespace details
+{
+
+struct socket_access;
+
+} //namespace details
+
 template<SocketInfo SI, InvInfo INV, ConnectionSettings CS>
 struct IncomingConnection
 {
@@ -82,13 +160,33 @@ class Socket
 {
   static_assert(!(SI.type == SocketType::Stream && SI.protocol == SocketProtocol::UDP));
   static_assert(!(SI.type == SocketType::Datagram && SI.protocol == SocketProtocol::TCP));
+  static_assert(!(SI.type == SocketType::SeqPacket && SI.address_family != AddressFamily::Unix));
+  static_assert((SI.address_family == AddressFamily::Unix) == (SI.protocol == SocketProtocol::Default));
+  static_assert(!SI.dual_stack || SI.address_family == AddressFamily::IPv6);
 
   friend struct Net;
+  friend struct details::socket_access;
 
   template<SocketInfo, InvInfo, ConnectionSettings>
   friend struct Socket;
 
+  static_assert(
+    !SCS.delta_encoding || (SCS.encoding == WireEncoding::Varint && SI.type == SocketType::Stream),
+    "delta encoding needs Varint encoding and stream socket");
+
+  static_assert(
+    !SCS.negotiate_byte_order ||
+      (SCS.convert_byte_order && SCS.encoding == WireEncoding::Raw && SI.type != SocketType::Datagram),
+    "byte order negotiation needs convert_byte_order, raw encoding and connection oriented socket");
+
+  static_assert(
+    !SCS.checksum || (SCS.encoding == WireEncoding::Raw && SI.type == SocketType::Datagram),
+    "checksum needs raw encoding and datagram socket");
+
   details::socket_resource m_handle_;
+  [[no_unique_address]] std::conditional_t<SCS.delta_encoding, details::delta_state, details::no_delta_state> m_delta_;
+  [[no_unique_address]] std::conditional_t<
+    SCS.negotiate_byte_order, details::negotiated_byte_order, details::fixed_byte_order> m_byte_order_;
 
   Socket(details::socket_resource&& handle) noexcept :
     m_handle_(std::forward<details::socket_resource>(handle)) {}
@@ -102,6 +200,21 @@ class Socket
     return t;
   }
 
+  //conversion of packets of this connection, skipped after handshake with peer of same byte order
+  template<packet_type T>
+  constexpr T convert_connected(T t) const noexcept
+  {
+    if(converts_byte_order())
+      details::convert_byte_order(t);
+
+    return t;
+  }
+
+  std::optional<sys_errc::ErrorCode> exchange_hello() noexcept
+  {
+    return details::exchange_hello(m_handle_, SCS.layout_fingerprint, SCS.hello_timeout_ms, m_byte_order_.native);
+  }
+
   template<typename T>
   struct extra_byte
   {
@@ -111,6 +224,17 @@ class Socket
     constexpr operator T&() noexcept { return obj; }
   };
 
+  //packet followed by checksum trailer and extra byte detecting oversized datagram
+  template<typename T>
+  struct checksummed
+  {
+    T obj;
+    details::checksum_trailer crc;
+    std::byte byte;
+
+    static constexpr std::size_t size = sizeof(T) + sizeof(details::checksum_trailer);
+  };
+
   template<typename V>
   struct variant_storage;
 
@@ -133,18 +257,146 @@ class Socket
     return std::bit_cast<extra_bytes<To, N>>(storage).obj;
   }
 
+  template<var_packet_type VP>
+  bool decode_var_prefix(const std::byte* data, std::size_t& count, typename VP::header_type& header) const noexcept
+  {
+    return converts_byte_order() ?
+      details::decode_var_prefix<VP, SCS.convert_byte_order>(data, count, header) :
+      details::decode_var_prefix<VP, false>(data, count, header);
+  }
+
+  //Varint encoding of packet, returns end of encoding
+  template<ConnectionSettings CS, packet_type T>
+  std::byte* encode(const T& t, std::byte* out)
+  {
+    if constexpr(CS.delta_encoding)
+    {
+      T& prev = m_delta_.template sent<T>();
+      out = details::encode_value(t, &prev, out);
+      prev = t;
+
+      return out;
+    }
+    else
+      return details::encode_value(t, static_cast<const T*>(nullptr), out);
+  }
+
+  //decodes packet occupying exactly n bytes
+  template<ConnectionSettings CS, packet_type T>
+  bool decode(const std::byte* in, std::size_t n, T& t)
+  {
+    if constexpr(CS.delta_encoding)
+    {
+      T& prev = m_delta_.template received<T>();
+      if(details::decode_value(t, &prev, in, in + n) != in + n) return false;
+      prev = t;
+
+      return true;
+    }
+    else
+      return details::decode_value(t, static_cast<const T*>(nullptr), in, in + n) == in + n;
+  }
+
+  //stream variant packet is framed by index of its alternative, alternative size is implied by index
+  template<packet_variant_type V>
+  using variant_tag_t = std::conditional_t<(std::variant_size_v<V> <= 256), uint8_t, uint16_t>;
+
+  template<packet_variant_type V, std::size_t I>
+  static auto recv_alternative(details::socket_resource::Handle h, bool convert, V& v) noexcept
+  {
+    using T = std::variant_alternative_t<I, V>;
+
+    T t;
+    auto r = ::recv(h, reinterpret_cast<char*>(&t), sizeof(T), MSG_WAITALL);
+
+    if(r == sizeof(T))
+    {
+      if(convert) details::convert_byte_order(t);
+      v.template emplace<I>(t);
+    }
+
+    return r;
+  }
+
+  //receiver of each alternative indexed by tag, so only alternative named by tag is received and validated
+  template<packet_variant_type V>
+  static constexpr auto alternative_receivers = []<std::size_t... Is>(std::index_sequence<Is...>)
+  {
+    return std::array{&recv_alternative<V, Is>...};
+  }(std::make_index_sequence<std::variant_size_v<V>>{});
+
+  template<packet_variant_type V>
+  static constexpr auto alternative_sizes = []<std::size_t... Is>(std::index_sequence<Is...>)
+  {
+    return std::array{sizeof(std::variant_alternative_t<Is, V>)...};
+  }(std::make_index_sequence<std::variant_size_v<V>>{});
+
   static constexpr sys_errc::ErrorCode not_connected_err       = sys_errc::common::sockets::not_connected;
   static constexpr sys_errc::ErrorCode wrong_protocol_type_err = sys_errc::common::sockets::wrong_protocol_type;
   static constexpr sys_errc::ErrorCode invalid_argument_err    = sys_errc::common::sockets::invalid_argument;
 
+  //sends encoded packet to each address in chunks, reports failed ones to on_error
+  template<typename F>
+  std::size_t fanout_buffer(
+    details::const_buffer buffer, std::span<const Address<SI.address_family>> addrs, F& on_error) noexcept
+  {
+    details::outgoing_datagram dgrams[details::max_batch_size];
+    std::size_t sent = 0;
+
+    for(std::size_t base = 0; base < addrs.size(); base += details::max_batch_size)
+    {
+      const auto count = static_cast<unsigned>((std::min)(addrs.size() - base, std::size_t(details::max_batch_size)));
+
+      for(unsigned i = 0; i != count; ++i)
+        dgrams[i] = { buffer, details::to_sockaddr_ptr(&addrs[base + i]), details::sockaddr_length(addrs[base + i]) };
+
+      unsigned i = 0;
+      while(i != count)
+      {
+        int r = details::send_datagrams(m_handle_, dgrams + i, count - i);
+
+        //first datagram failed, report it and continue with others
+        if(r < 0)
+        {
+          on_error(base + i++, sys_errc::last_error());
+          continue;
+        }
+
+        i += static_cast<unsigned>(r);
+        sent += static_cast<std::size_t>(r);
+      }
+    }
+
+    return sent;
+  }
+
 public:
   static constexpr SocketInfo socket_info = SI;
   static constexpr InvInfo inv_info = INV;
   static constexpr ConnectionSettings connection_settings = SCS;
 
+  //true when packets of connection are converted to network byte order
+  constexpr bool converts_byte_order() const noexcept
+  {
+    if constexpr(SCS.negotiate_byte_order)
+      return !m_byte_order_.native;
+    else
+      return SCS.convert_byte_order;
+  }
+
+  //Negotiates byte order with peer, both ends must call it before any other I/O.
+  //Sockets made by Net connect functions and accept have already done it
+  template<auto EHP = ehl::Policy::Exception> requires (SCS.negotiate_byte_order && INV.connected)
+  [[nodiscard]] ehl::Result_t<void, sys_errc::ErrorCode, EHP> handshake() noexcept(EHP != ehl::Policy::Exception)
+  {
+    const auto err = exchange_hello();
+
+    EHL_THROW_IF(err.has_value(), *err);
+  }
+
   template<ConnectionSettings CS = default_connection_settings, auto EHP = ehl::Policy::Exception>
   [[nodiscard]] ehl::Result_t<IncomingConnection<SI, inv_connect, CS>, sys_errc::ErrorCode, EHP> accept()
-    noexcept(EHP != ehl::Policy::Exception) requires (SI.type == SocketType::Stream && INV.binded && INV.listening)
+    noexcept(EHP != ehl::Policy::Exception) requires (SI.type != SocketType::Datagram && INV.binded && INV.listening)
   {
     details::sockaddr_type<SI.address_family> addr;
     details::socklen_type addrlen = sizeof(addr);
@@ -153,13 +405,93 @@ public:
 
     EHL_THROW_IF(r.is_invalid(), sys_errc::last_error());
 
-    return IncomingConnection<SI, inv_connect, CS>{std::move(r), details::from_sockaddr(addr)};
+    IncomingConnection<SI, inv_connect, CS> conn{std::move(r), details::from_sockaddr(addr, addrlen)};
+
+    if constexpr(CS.negotiate_byte_order)
+    {
+      const auto err = conn.sock.exchange_hello();
+
+      EHL_THROW_IF(err.has_value(), *err);
+    }
+
+    return conn;
   }
 
   template<packet_type T, auto EHP = ehl::Policy::Exception> requires (INV.connected)
   [[nodiscard]] ehl::Result_t<valid_packet<T>, sys_errc::ErrorCode, EHP> recv() noexcept(EHP != ehl::Policy::Exception)
   {
-    std::conditional_t<SI.type == SocketType::Datagram, extra_byte<T>, T> t;
+    if constexpr(SCS.encoding == WireEncoding::Varint)
+    {
+      constexpr std::size_t max_size = details::max_encoded_size_v<T>;
+
+      std::byte buf[max_size + 1];
+      std::size_t size = 0;
+
+      if constexpr(SI.type == SocketType::Stream)
+      {
+        std::byte len[sizeof(details::encoded_length_t<T>)];
+
+        auto r = ::recv(m_handle_, reinterpret_cast<char*>(len), sizeof(len), MSG_WAITALL);
+
+        EHL_THROW_IF(
+          r != sizeof(len),
+          r < 0 ? sys_errc::last_error() :
+                  (r == 0 ? not_connected_err : wrong_protocol_type_err));
+
+        //length is in network byte order
+        for(std::byte b : len) size = size << 8 | std::to_integer<std::size_t>(b);
+
+        EHL_THROW_IF(size > max_size, wrong_protocol_type_err);
+
+        r = ::recv(m_handle_, reinterpret_cast<char*>(buf), static_cast<int>(size), MSG_WAITALL);
+
+        EHL_THROW_IF(
+          r < 0 || static_cast<std::size_t>(r) != size,
+          r < 0 ? sys_errc::last_error() :
+                  (r == 0 ? not_connected_err : wrong_protocol_type_err));
+      }
+      else
+      {
+        auto r = ::recv(m_handle_, reinterpret_cast<char*>(buf), sizeof(buf), 0);
+
+        EHL_THROW_IF(
+          r <= 0 || static_cast<std::size_t>(r) > max_size,
+          r < 0 ? sys_errc::last_error() :
+                  (r == 0 ? not_connected_err : wrong_protocol_type_err));
+
+        size = static_cast<std::size_t>(r);
+      }
+
+      T result;
+
+      EHL_THROW_IF(!decode<SCS>(buf, size, result) || !result.is_valid(), wrong_protocol_type_err);
+
+      return std::bit_cast<valid_packet<T>>(result);
+    }
+
+    if constexpr(SCS.checksum)
+    {
+      checksummed<T> c;
+
+      auto r = ::recv(m_handle_, reinterpret_cast<char*>(&c), sizeof(c), 0);
+
+      EHL_THROW_IF(
+        r != c.size,
+        r < 0 ? sys_errc::last_error() :
+                (r == 0 ? not_connected_err : wrong_protocol_type_err));
+
+      T result = c.obj;
+
+      EHL_THROW_IF(!details::check_checksum(&result, sizeof(T), c.crc), wrong_protocol_type_err);
+
+      result = convert_connected<T>(result);
+
+      EHL_THROW_IF(!result.is_valid(), wrong_protocol_type_err);
+
+      return std::bit_cast<valid_packet<T>>(result);
+    }
+
+    std::conditional_t<SI.type != SocketType::Stream, extra_byte<T>, T> t;
 
     //ensure all data received for stream
     constexpr int flags = SI.type == SocketType::Stream ? MSG_WAITALL : 0;
@@ -171,7 +503,7 @@ public:
       r < 0 ? sys_errc::last_error() :
               (r == 0 ? not_connected_err : wrong_protocol_type_err));
 
-    T result = convert_byte_order<SCS, T>(t);
+    T result = convert_connected<T>(t);
 
     EHL_THROW_IF(!result.is_valid(), wrong_protocol_type_err);
 
@@ -179,7 +511,7 @@ public:
   }
 
   template<packet_variant_type V, auto EHP = ehl::Policy::Exception>
-    requires (INV.connected && SI.type == SocketType::Datagram)
+    requires (INV.connected && SI.type != SocketType::Stream && raw_unchecked_settings<SCS>)
   [[nodiscard]] ehl::Result_t<valid_packet_variant<V>, sys_errc::ErrorCode, EHP> recv() noexcept(EHP != ehl::Policy::Exception)
   {
     extra_byte<variant_storage<V>> storage;
@@ -193,7 +525,7 @@ public:
 
     const auto validate = [&]<typename T>()
     {
-      T t = convert_byte_order<SCS>(storage_bit_cast<T>(storage.obj.data));
+      T t = convert_connected(storage_bit_cast<T>(storage.obj.data));
       return size == sizeof(T) && t.is_valid();
     };
 
@@ -211,18 +543,93 @@ public:
       {
         using T = std::variant_alternative_t<I, V>;
 
-        if(v[I]) return convert_byte_order<SCS>(storage_bit_cast<T>(storage.obj.data));
+        if(v[I]) return convert_connected(storage_bit_cast<T>(storage.obj.data));
 
         if constexpr(I+1 != std::variant_size_v<V>)
           return self.template operator()<I+1>();
       }());
   }
 
+  template<packet_variant_type V, auto EHP = ehl::Policy::Exception>
+    requires (INV.connected && SI.type == SocketType::Stream && raw_unchecked_settings<SCS>)
+  [[nodiscard]] ehl::Result_t<valid_packet_variant<V>, sys_errc::ErrorCode, EHP> recv() noexcept(EHP != ehl::Policy::Exception)
+  {
+    variant_tag_t<V> tag;
+
+    auto r = ::recv(m_handle_, reinterpret_cast<char*>(&tag), sizeof(tag), MSG_WAITALL);
+
+    EHL_THROW_IF(
+      r != sizeof(tag),
+      r < 0 ? sys_errc::last_error() :
+              (r == 0 ? not_connected_err : wrong_protocol_type_err));
+
+    if(converts_byte_order())
+      details::convert_byte_order(tag);
+
+    const std::size_t index = tag;
+
+    //stream can`t be resynchronized after unknown tag
+    EHL_THROW_IF(index >= std::variant_size_v<V>, wrong_protocol_type_err);
+
+    V v;
+    r = alternative_receivers<V>[index](m_handle_, converts_byte_order(), v);
+
+    EHL_THROW_IF(
+      r < 0 || static_cast<std::size_t>(r) != alternative_sizes<V>[index],
+      r < 0 ? sys_errc::last_error() :
+              (r == 0 ? not_connected_err : wrong_protocol_type_err));
+
+    EHL_THROW_IF(!packet_variant_validate_predicate<V>(v), wrong_protocol_type_err);
+
+    return std::bit_cast<valid_packet_variant<V>>(v);
+  }
+
   template<auto EHP = ehl::Policy::Exception, packet_type T> requires (INV.connected)
   [[nodiscard]] ehl::Result_t<void, sys_errc::ErrorCode, EHP> send(const valid_packet<T>& t)
     noexcept(EHP != ehl::Policy::Exception)
   {
-    T t_copy = convert_byte_order<SCS, T>(t);
+    if constexpr(SCS.encoding == WireEncoding::Varint)
+    {
+      using length_type = details::encoded_length_t<T>;
+      constexpr std::size_t prefix = SI.type == SocketType::Stream ? sizeof(length_type) : 0;
+
+      std::byte buf[prefix + details::max_encoded_size_v<T>];
+      const std::size_t size = static_cast<std::size_t>(encode<SCS>(static_cast<const T&>(t), buf + prefix) - (buf + prefix));
+
+      if constexpr(SI.type == SocketType::Stream)
+      {
+        //length in network byte order
+        for(std::size_t i = 0; i != prefix; ++i) buf[i] = static_cast<std::byte>(size >> (8 * (prefix - 1 - i)));
+
+        const details::const_buffer frame{buf, prefix + size};
+
+        EHL_THROW_IF(!details::send_all(m_handle_, &frame, 1), sys_errc::last_error());
+      }
+      else
+      {
+        auto r = ::send(m_handle_, reinterpret_cast<const char*>(buf), size, 0);
+
+        //return system error or wrong_protocol_type to indicate interruption of send
+        EHL_THROW_IF(r < 0 || static_cast<std::size_t>(r) != size, r < 0 ? sys_errc::last_error() : wrong_protocol_type_err);
+      }
+
+      return;
+    }
+
+    if constexpr(SCS.checksum)
+    {
+      checksummed<T> c{convert_connected<T>(t), {}, {}};
+      details::put_checksum(&c.obj, sizeof(T), c.crc);
+
+      auto r = ::send(m_handle_, reinterpret_cast<const char*>(&c), c.size, 0);
+
+      //return system error or wrong_protocol_type to indicate interruption of send
+      EHL_THROW_IF(r != c.size, r < 0 ? sys_errc::last_error() : wrong_protocol_type_err);
+
+      return;
+    }
+
+    T t_copy = convert_connected<T>(t);
 
     auto r = ::send(m_handle_, reinterpret_cast<const char*>(&t_copy), sizeof(T), 0);
 
@@ -239,14 +646,15 @@ public:
     return send<EHP, T>(std::bit_cast<valid_packet<T>>(t));
   }
 
-  template<auto EHP = ehl::Policy::Exception, packet_variant_type V> requires (INV.connected && SI.type == SocketType::Datagram)
+  template<auto EHP = ehl::Policy::Exception, packet_variant_type V>
+    requires (INV.connected && SI.type != SocketType::Stream && raw_unchecked_settings<SCS>)
   [[nodiscard]] ehl::Result_t<void, sys_errc::ErrorCode, EHP> send(const valid_packet_variant<V>& v)
     noexcept(EHP != ehl::Policy::Exception)
   {
     V v_copy = v;
     const auto s = std::visit([&](auto& p)
     {
-      p = convert_byte_order<SCS>(p);
+      p = convert_connected(p);
       return std::span<const char>{reinterpret_cast<const char*>(&p), sizeof(p)};
     }, v_copy);
 
@@ -256,7 +664,30 @@ public:
     EHL_THROW_IF(r != s.size_bytes(), r < 0 ? sys_errc::last_error() : wrong_protocol_type_err);
   }
 
-  template<auto EHP = ehl::Policy::Exception, packet_variant_type V> requires (INV.connected && SI.type == SocketType::Datagram)
+  template<auto EHP = ehl::Policy::Exception, packet_variant_type V>
+    requires (INV.connected && SI.type == SocketType::Stream && raw_unchecked_settings<SCS>)
+  [[nodiscard]] ehl::Result_t<void, sys_errc::ErrorCode, EHP> send(const valid_packet_variant<V>& v)
+    noexcept(EHP != ehl::Policy::Exception)
+  {
+    V v_copy = v;
+
+    variant_tag_t<V> tag{static_cast<decltype(tag.underlying_value())>(v_copy.index())};
+    if(converts_byte_order())
+      details::convert_byte_order(tag);
+
+    const auto s = std::visit([&](auto& p)
+    {
+      p = convert_connected(p);
+      return details::const_buffer{&p, sizeof(p)};
+    }, v_copy);
+
+    //tag and packet go in single gathered write
+    const details::const_buffer bufs[] = {{&tag, sizeof(tag)}, s};
+
+    EHL_THROW_IF(!details::send_all(m_handle_, bufs, 2), sys_errc::last_error());
+  }
+
+  template<auto EHP = ehl::Policy::Exception, packet_variant_type V> requires (INV.connected)
   [[nodiscard]] ehl::Result_t<void, sys_errc::ErrorCode, EHP> send(const V& v)
     noexcept(EHP != ehl::Policy::Exception)
   {
@@ -265,6 +696,118 @@ public:
     return send<EHP, V>(std::bit_cast<valid_packet_variant<V>>(v));
   }
 
+  //Receives packet without converting its byte order, fields are converted on access
+  template<packet_type T, auto EHP = ehl::Policy::Exception> requires (INV.connected && raw_settings<SCS>)
+  [[nodiscard]] ehl::Result_t<lazy_packet<T>, sys_errc::ErrorCode, EHP> recv_lazy() noexcept(EHP != ehl::Policy::Exception)
+  {
+    auto p = details::lazy_packet_access::make<T>(converts_byte_order());
+
+    //ensure all data received for stream
+    constexpr int flags = SI.type == SocketType::Stream ? MSG_WAITALL : 0;
+    constexpr std::size_t size = SCS.checksum ? checksummed<T>::size : sizeof(T);
+    auto r = ::recv(
+      m_handle_, reinterpret_cast<char*>(details::lazy_packet_access::data(p)),
+      SI.type == SocketType::Stream ? size : size + 1, flags);
+
+    EHL_THROW_IF(
+      r != size,
+      r < 0 ? sys_errc::last_error() :
+              (r == 0 ? not_connected_err : wrong_protocol_type_err));
+
+    if constexpr(SCS.checksum)
+    {
+      EHL_THROW_IF(!details::lazy_packet_access::check_checksum(p), wrong_protocol_type_err);
+    }
+
+    EHL_THROW_IF(!details::lazy_packet_access::is_valid(p), wrong_protocol_type_err);
+
+    return p;
+  }
+
+  //Sends header and tail as one var_packet, tail must not be longer than VP::max_count
+  template<var_packet_type VP, auto EHP = ehl::Policy::Exception> requires (INV.connected && raw_unchecked_settings<SCS>)
+  [[nodiscard]] ehl::Result_t<void, sys_errc::ErrorCode, EHP> send(
+    const valid_packet<typename VP::header_type>& header, std::span<const typename VP::element_type> tail)
+    noexcept(EHP != ehl::Policy::Exception)
+  {
+    EHL_THROW_IF(tail.size() > VP::max_count, invalid_argument_err);
+
+    constexpr bool stream = SI.type == SocketType::Stream;
+
+    const bool sent = converts_byte_order() ?
+      details::send_var_packet<VP, SCS.convert_byte_order, stream>(m_handle_, header, tail) :
+      details::send_var_packet<VP, false, stream>(m_handle_, header, tail);
+
+    EHL_THROW_IF(!sent, sys_errc::last_error());
+  }
+
+  template<var_packet_type VP, auto EHP = ehl::Policy::Exception> requires (INV.connected)
+  [[nodiscard]] ehl::Result_t<void, sys_errc::ErrorCode, EHP> send(
+    const typename VP::header_type& header, std::span<const typename VP::element_type> tail)
+    noexcept(EHP != ehl::Policy::Exception)
+  {
+    EHL_THROW_IF(!header.is_valid(), invalid_argument_err);
+
+    return send<VP, EHP>(std::bit_cast<valid_packet<typename VP::header_type>>(header), tail);
+  }
+
+  //Receives var_packet without copying tail: elements are received into buf and converted in place,
+  //returned tail refers to buf
+  template<var_packet_type VP, auto EHP = ehl::Policy::Exception> requires (INV.connected && raw_unchecked_settings<SCS>)
+  [[nodiscard]] ehl::Result_t<var_packet_view<VP>, sys_errc::ErrorCode, EHP> recv(typename VP::buffer& buf)
+    noexcept(EHP != ehl::Policy::Exception)
+  {
+    using H = typename VP::header_type;
+    using E = typename VP::element_type;
+
+    std::size_t count = 0;
+    H header;
+
+    if constexpr(SI.type == SocketType::Stream)
+    {
+      auto r = ::recv(m_handle_, reinterpret_cast<char*>(buf.data), VP::tail_offset, MSG_WAITALL);
+
+      EHL_THROW_IF(
+        r != VP::tail_offset,
+        r < 0 ? sys_errc::last_error() :
+                (r == 0 ? not_connected_err : wrong_protocol_type_err));
+
+      //stream can`t be resynchronized after wrong element count
+      EHL_THROW_IF(!decode_var_prefix<VP>(buf.data, count, header), wrong_protocol_type_err);
+
+      if(count != 0)
+      {
+        r = ::recv(m_handle_, reinterpret_cast<char*>(buf.data + VP::tail_offset), count * sizeof(E), MSG_WAITALL);
+
+        EHL_THROW_IF(
+          r < 0 || static_cast<std::size_t>(r) != count * sizeof(E),
+          r < 0 ? sys_errc::last_error() :
+                  (r == 0 ? not_connected_err : wrong_protocol_type_err));
+      }
+    }
+    else
+    {
+      auto r = ::recv(m_handle_, reinterpret_cast<char*>(buf.data), sizeof(buf.data), 0);
+
+      EHL_THROW_IF(
+        r < 0 || static_cast<std::size_t>(r) < VP::tail_offset,
+        r < 0 ? sys_errc::last_error() :
+                (r == 0 ? not_connected_err : wrong_protocol_type_err));
+
+      EHL_THROW_IF(
+        (!decode_var_prefix<VP>(buf.data, count, header) || static_cast<std::size_t>(r) != VP::size(count)),
+        wrong_protocol_type_err);
+    }
+
+    EHL_THROW_IF(!header.is_valid(), wrong_protocol_type_err);
+
+    return var_packet_view<VP>{
+      std::bit_cast<valid_packet<H>>(header),
+      converts_byte_order() ?
+        details::decode_var_tail<E, SCS.convert_byte_order>(buf.data + VP::tail_offset, count) :
+        details::decode_var_tail<E, false>(buf.data + VP::tail_offset, count)};
+  }
+
   template<typename T>
   struct recvfrom_result
   {
@@ -279,33 +822,80 @@ public:
     Address<SI.address_family> addr;
   };
 
+  template<var_packet_type VP>
+  struct recvfrom_result<VP>
+  {
+    var_packet_view<VP> value;
+    Address<SI.address_family> addr;
+  };
+
+  template<packet_type T>
+  struct recvfrom_result<lazy_packet<T>>
+  {
+    lazy_packet<T> value;
+    Address<SI.address_family> addr;
+  };
+
   template<packet_type T, ConnectionSettings CS = default_connection_settings, auto EHP = ehl::Policy::Exception>
     requires (SI.type == SocketType::Datagram)
   [[nodiscard]] ehl::Result_t<recvfrom_result<T>, sys_errc::ErrorCode, EHP> recvfrom()
     noexcept(EHP != ehl::Policy::Exception)
   {
-    extra_byte<T> t;
+    static_assert(!CS.delta_encoding, "delta encoding needs stream socket");
+
+    if constexpr(CS.encoding == WireEncoding::Varint)
+    {
+      constexpr std::size_t max_size = details::max_encoded_size_v<T>;
+
+      std::byte buf[max_size + 1];
+      details::sockaddr_type<SI.address_family> addr;
+      details::socklen_type addrlen = sizeof(addr);
+
+      auto r = ::recvfrom(
+        m_handle_, reinterpret_cast<char*>(buf), sizeof(buf), 0, details::to_sockaddr_ptr(&addr), &addrlen);
+
+      EHL_THROW_IF(
+        r <= 0 || static_cast<std::size_t>(r) > max_size,
+        r < 0 ? sys_errc::last_error() :
+                (r == 0 ? not_connected_err : wrong_protocol_type_err));
+
+      T result;
+
+      EHL_THROW_IF(!decode<CS>(buf, static_cast<std::size_t>(r), result), wrong_protocol_type_err);
+      EHL_THROW_IF(!result.is_valid(), invalid_argument_err);
+
+      return recvfrom_result<T>{std::bit_cast<valid_packet<T>>(result), details::from_sockaddr(addr, addrlen)};
+    }
+
+    std::conditional_t<CS.checksum, checksummed<T>, extra_byte<T>> t;
     details::sockaddr_type<SI.address_family> addr;
     details::socklen_type addrlen = sizeof(addr);
 
     auto r = ::recvfrom(
       m_handle_, reinterpret_cast<char*>(&t), sizeof(t), 0, details::to_sockaddr_ptr(&addr), &addrlen);
 
+    constexpr std::size_t size = CS.checksum ? checksummed<T>::size : sizeof(T);
+
     //return system error or not_connected to indicate connection issue or wrong_protocol_type to indicate wrong packet size
     EHL_THROW_IF(
-      r != sizeof(T),
+      r != size,
       r < 0 ? sys_errc::last_error() :
               (r == 0 ? not_connected_err : wrong_protocol_type_err));
 
-    T result = convert_byte_order<CS, T>(t);
+    if constexpr(CS.checksum)
+    {
+      EHL_THROW_IF(!details::check_checksum(&t.obj, sizeof(T), t.crc), wrong_protocol_type_err);
+    }
+
+    T result = convert_byte_order<CS, T>(t.obj);
 
     EHL_THROW_IF(!result.is_valid(), invalid_argument_err);
 
-    return recvfrom_result<T>{std::bit_cast<valid_packet<T>>(result), details::from_sockaddr(addr)};
+    return recvfrom_result<T>{std::bit_cast<valid_packet<T>>(result), details::from_sockaddr(addr, addrlen)};
   }
 
   template<packet_variant_type V, ConnectionSettings CS = default_connection_settings, auto EHP = ehl::Policy::Exception>
-    requires (SI.type == SocketType::Datagram)
+    requires (SI.type == SocketType::Datagram && raw_unchecked_settings<CS>)
   [[nodiscard]] ehl::Result_t<recvfrom_result<V>, sys_errc::ErrorCode, EHP> recvfrom()
     noexcept(EHP != ehl::Policy::Exception)
   {
@@ -346,7 +936,7 @@ public:
         return self.template operator()<I+1>();
     }();
 
-    return recvfrom_result<V>{std::bit_cast<valid_packet_variant<V>>(res), details::from_sockaddr(addr)};
+    return recvfrom_result<V>{std::bit_cast<valid_packet_variant<V>>(res), details::from_sockaddr(addr, addrlen)};
   }
 
   template<ConnectionSettings CS = default_connection_settings, auto EHP = ehl::Policy::Exception, packet_type T>
@@ -355,9 +945,39 @@ public:
     const valid_packet<T>& t, const Address<SI.address_family>& addr)
       noexcept(EHP != ehl::Policy::Exception)
   {
-    T t_copy = convert_byte_order<CS, T>(t);
+    static_assert(!CS.delta_encoding, "delta encoding needs stream socket");
 
-    details::socklen_type addrlen = sizeof(addr);
+    details::socklen_type addrlen = details::sockaddr_length(addr);
+
+    if constexpr(CS.encoding == WireEncoding::Varint)
+    {
+      std::byte buf[details::max_encoded_size_v<T>];
+      const std::size_t size = static_cast<std::size_t>(encode<CS>(static_cast<const T&>(t), buf) - buf);
+
+      auto r = ::sendto(
+        m_handle_, reinterpret_cast<const char*>(buf), size, 0, details::to_sockaddr_ptr(&addr), addrlen);
+
+      //return system error or wrong_protocol_type to indicate interruption of send
+      EHL_THROW_IF(r < 0 || static_cast<std::size_t>(r) != size, r < 0 ? sys_errc::last_error() : wrong_protocol_type_err);
+
+      return;
+    }
+
+    if constexpr(CS.checksum)
+    {
+      checksummed<T> c{convert_byte_order<CS, T>(t), {}, {}};
+      details::put_checksum(&c.obj, sizeof(T), c.crc);
+
+      auto r = ::sendto(
+        m_handle_, reinterpret_cast<const char*>(&c), c.size, 0, details::to_sockaddr_ptr(&addr), addrlen);
+
+      //return system error or wrong_protocol_type to indicate interruption of send
+      EHL_THROW_IF(r != c.size, r < 0 ? sys_errc::last_error() : wrong_protocol_type_err);
+
+      return;
+    }
+
+    T t_copy = convert_byte_order<CS, T>(t);
 
     auto r = ::sendto(
       m_handle_, reinterpret_cast<const char*>(&t_copy), sizeof(T), 0, details::to_sockaddr_ptr(&addr), addrlen);
@@ -377,7 +997,7 @@ public:
   }
 
   template<ConnectionSettings CS = default_connection_settings, auto EHP = ehl::Policy::Exception, packet_variant_type V>
-    requires (SI.type == SocketType::Datagram)
+    requires (SI.type == SocketType::Datagram && raw_unchecked_settings<CS>)
   [[nodiscard]] ehl::Result_t<void, sys_errc::ErrorCode, EHP> sendto(
     const valid_packet_variant<V>& v, const Address<SI.address_family>& addr)
       noexcept(EHP != ehl::Policy::Exception)
@@ -389,7 +1009,7 @@ public:
       return std::span<const char>{reinterpret_cast<const char*>(&p), sizeof(p)};
     }, v_copy);
 
-    details::socklen_type addrlen = sizeof(addr);
+    details::socklen_type addrlen = details::sockaddr_length(addr);
 
     auto r = ::sendto(
       m_handle_, s.data(), s.size_bytes(), 0, details::to_sockaddr_ptr(&addr), addrlen);
@@ -409,6 +1029,241 @@ public:
     return sendto<CS, EHP, V>(std::bit_cast<valid_packet_variant<V>>(v), addr);
   }
 
+  //Sends same packet to all addresses: packet is encoded once and sent by sendmmsg in chunks where supported.
+  //Failed destination is reported by on_error(index of address, error) and does not stop others,
+  //returns number of destinations packet was sent to
+  template<
+    ConnectionSettings CS = default_connection_settings,
+    auto EHP = ehl::Policy::Exception,
+    packet_type T,
+    typename F> requires (SI.type == SocketType::Datagram)
+  [[nodiscard]] ehl::Result_t<std::size_t, sys_errc::ErrorCode, EHP> fanout(
+    const valid_packet<T>& t, std::span<const Address<SI.address_family>> addrs, F&& on_error)
+      noexcept(EHP != ehl::Policy::Exception)
+  {
+    static_assert(!CS.delta_encoding, "delta encoding needs stream socket");
+
+    if constexpr(CS.encoding == WireEncoding::Varint)
+    {
+      std::byte buf[details::max_encoded_size_v<T>];
+      const std::size_t size = static_cast<std::size_t>(encode<CS>(static_cast<const T&>(t), buf) - buf);
+
+      return fanout_buffer({buf, size}, addrs, on_error);
+    }
+    else if constexpr(CS.checksum)
+    {
+      checksummed<T> c{convert_byte_order<CS, T>(t), {}, {}};
+      details::put_checksum(&c.obj, sizeof(T), c.crc);
+
+      return fanout_buffer({&c, c.size}, addrs, on_error);
+    }
+    else
+    {
+      T t_copy = convert_byte_order<CS, T>(t);
+
+      return fanout_buffer({&t_copy, sizeof(T)}, addrs, on_error);
+    }
+  }
+
+  template<
+    ConnectionSettings CS = default_connection_settings,
+    auto EHP = ehl::Policy::Exception,
+    packet_variant_type V,
+    typename F> requires (SI.type == SocketType::Datagram && raw_unchecked_settings<CS>)
+  [[nodiscard]] ehl::Result_t<std::size_t, sys_errc::ErrorCode, EHP> fanout(
+    const valid_packet_variant<V>& v, std::span<const Address<SI.address_family>> addrs, F&& on_error)
+      noexcept(EHP != ehl::Policy::Exception)
+  {
+    V v_copy = v;
+    const auto buffer = std::visit([&](auto& p)
+    {
+      p = convert_byte_order<CS>(p);
+      return details::const_buffer{&p, sizeof(p)};
+    }, v_copy);
+
+    return fanout_buffer(buffer, addrs, on_error);
+  }
+
+  template<
+    ConnectionSettings CS = default_connection_settings,
+    auto EHP = ehl::Policy::Exception,
+    packet_type T,
+    typename F> requires (SI.type == SocketType::Datagram)
+  [[nodiscard]] ehl::Result_t<std::size_t, sys_errc::ErrorCode, EHP> fanout(
+    const T& t, std::span<const Address<SI.address_family>> addrs, F&& on_error)
+      noexcept(EHP != ehl::Policy::Exception)
+  {
+    EHL_THROW_IF(!t.is_valid(), invalid_argument_err);
+
+    return fanout<CS, EHP, T>(std::bit_cast<valid_packet<T>>(t), addrs, on_error);
+  }
+
+  template<
+    ConnectionSettings CS = default_connection_settings,
+    auto EHP = ehl::Policy::Exception,
+    packet_variant_type V,
+    typename F> requires (SI.type == SocketType::Datagram)
+  [[nodiscard]] ehl::Result_t<std::size_t, sys_errc::ErrorCode, EHP> fanout(
+    const V& v, std::span<const Address<SI.address_family>> addrs, F&& on_error)
+      noexcept(EHP != ehl::Policy::Exception)
+  {
+    EHL_THROW_IF(!packet_variant_validate_predicate<V>(v), invalid_argument_err);
+
+    return fanout<CS, EHP, V>(std::bit_cast<valid_packet_variant<V>>(v), addrs, on_error);
+  }
+
+  template<packet_type T, ConnectionSettings CS = default_connection_settings, auto EHP = ehl::Policy::Exception>
+    requires (SI.type == SocketType::Datagram && raw_settings<CS>)
+  [[nodiscard]] ehl::Result_t<recvfrom_result<lazy_packet<T>>, sys_errc::ErrorCode, EHP> recvfrom_lazy()
+    noexcept(EHP != ehl::Policy::Exception)
+  {
+    auto p = details::lazy_packet_access::make<T>(CS.convert_byte_order);
+    details::sockaddr_type<SI.address_family> addr;
+    details::socklen_type addrlen = sizeof(addr);
+
+    constexpr std::size_t size = CS.checksum ? checksummed<T>::size : sizeof(T);
+
+    auto r = ::recvfrom(
+      m_handle_, reinterpret_cast<char*>(details::lazy_packet_access::data(p)), size + 1, 0,
+      details::to_sockaddr_ptr(&addr), &addrlen);
+
+    EHL_THROW_IF(
+      r != size,
+      r < 0 ? sys_errc::last_error() :
+              (r == 0 ? not_connected_err : wrong_protocol_type_err));
+
+    if constexpr(CS.checksum)
+    {
+      EHL_THROW_IF(!details::lazy_packet_access::check_checksum(p), wrong_protocol_type_err);
+    }
+
+    EHL_THROW_IF(!details::lazy_packet_access::is_valid(p), invalid_argument_err);
+
+    return recvfrom_result<lazy_packet<T>>{std::move(p), details::from_sockaddr(addr, addrlen)};
+  }
+
+  //Receives burst of datagrams with single syscall where supported (recvmmsg), waits only for first one,
+  //calls on_packet(const valid_packet<T>&, const Address&) for each of them.
+  //Datagrams of wrong size, checksum or invalid packets are skipped instead of failing whole burst,
+  //returns number of delivered packets
+  template<packet_type T, ConnectionSettings CS = default_connection_settings, auto EHP = ehl::Policy::Exception, typename F>
+    requires (SI.type == SocketType::Datagram && raw_settings<CS>)
+  [[nodiscard]] ehl::Result_t<std::size_t, sys_errc::ErrorCode, EHP> recvfrom_batch(F&& on_packet)
+    noexcept(EHP != ehl::Policy::Exception)
+  {
+    using buffer = std::conditional_t<CS.checksum, checksummed<T>, extra_byte<T>>;
+
+    constexpr std::size_t size = CS.checksum ? checksummed<T>::size : sizeof(T);
+
+    //buffers are on stack, burst of big packets is limited to 64KiB
+    constexpr unsigned batch = static_cast<unsigned>(
+      std::clamp<std::size_t>(65536 / sizeof(buffer), 1, details::max_batch_size));
+
+    buffer bufs[batch];
+    details::sockaddr_type<SI.address_family> addrs[batch];
+    details::incoming_datagram dgrams[batch];
+
+    for(unsigned i = 0; i != batch; ++i)
+      dgrams[i] = { &bufs[i], sizeof(buffer), details::to_sockaddr_ptr(&addrs[i]), sizeof(addrs[i]), 0 };
+
+    int r = details::recv_datagrams(m_handle_, dgrams, batch);
+
+    EHL_THROW_IF(r < 0, sys_errc::last_error());
+
+    std::size_t delivered = 0;
+
+    for(int i = 0; i != r; ++i)
+    {
+      if(dgrams[i].received != size) continue;
+
+      if constexpr(CS.checksum)
+        if(!details::check_checksum(&bufs[i].obj, sizeof(T), bufs[i].crc)) continue;
+
+      T t = convert_byte_order<CS, T>(bufs[i].obj);
+
+      if(!t.is_valid()) continue;
+
+      ++delivered;
+      on_packet(std::bit_cast<valid_packet<T>>(t), details::from_sockaddr(addrs[i], dgrams[i].addrlen));
+    }
+
+    return delivered;
+  }
+
+  template<var_packet_type VP, ConnectionSettings CS = default_connection_settings, auto EHP = ehl::Policy::Exception>
+    requires (SI.type == SocketType::Datagram && raw_unchecked_settings<CS>)
+  [[nodiscard]] ehl::Result_t<recvfrom_result<VP>, sys_errc::ErrorCode, EHP> recvfrom(typename VP::buffer& buf)
+    noexcept(EHP != ehl::Policy::Exception)
+  {
+    using H = typename VP::header_type;
+    using E = typename VP::element_type;
+
+    details::sockaddr_type<SI.address_family> addr;
+    details::socklen_type addrlen = sizeof(addr);
+
+    auto r = ::recvfrom(
+      m_handle_, reinterpret_cast<char*>(buf.data), sizeof(buf.data), 0, details::to_sockaddr_ptr(&addr), &addrlen);
+
+    EHL_THROW_IF(
+      r < 0 || static_cast<std::size_t>(r) < VP::tail_offset,
+      r < 0 ? sys_errc::last_error() :
+              (r == 0 ? not_connected_err : wrong_protocol_type_err));
+
+    std::size_t count = 0;
+    H header;
+
+    EHL_THROW_IF(
+      (!details::decode_var_prefix<VP, CS.convert_byte_order>(buf.data, count, header) || static_cast<std::size_t>(r) != VP::size(count)),
+      wrong_protocol_type_err);
+
+    EHL_THROW_IF(!header.is_valid(), invalid_argument_err);
+
+    return recvfrom_result<VP>{
+      var_packet_view<VP>{
+        std::bit_cast<valid_packet<H>>(header),
+        details::decode_var_tail<E, CS.convert_byte_order>(buf.data + VP::tail_offset, count)},
+      details::from_sockaddr(addr, addrlen)};
+  }
+
+  template<var_packet_type VP, ConnectionSettings CS = default_connection_settings, auto EHP = ehl::Policy::Exception>
+    requires (SI.type == SocketType::Datagram && raw_unchecked_settings<CS>)
+  [[nodiscard]] ehl::Result_t<void, sys_errc::ErrorCode, EHP> sendto(
+    const valid_packet<typename VP::header_type>& header,
+    std::span<const typename VP::element_type> tail,
+    const Address<SI.address_family>& addr)
+      noexcept(EHP != ehl::Policy::Exception)
+  {
+    EHL_THROW_IF(tail.size() > VP::max_count, invalid_argument_err);
+
+    const bool sent = details::send_var_packet<VP, CS.convert_byte_order, false>(
+      m_handle_, header, tail, details::to_sockaddr_ptr(&addr), details::sockaddr_length(addr));
+
+    EHL_THROW_IF(!sent, sys_errc::last_error());
+  }
+
+  template<var_packet_type VP, ConnectionSettings CS = default_connection_settings, auto EHP = ehl::Policy::Exception>
+    requires (SI.type == SocketType::Datagram)
+  [[nodiscard]] ehl::Result_t<void, sys_errc::ErrorCode, EHP> sendto(
+    const typename VP::header_type& header,
+    std::span<const typename VP::element_type> tail,
+    const Address<SI.address_family>& addr)
+      noexcept(EHP != ehl::Policy::Exception)
+  {
+    EHL_THROW_IF(!header.is_valid(), invalid_argument_err);
+
+    return sendto<VP, CS, EHP>(std::bit_cast<valid_packet<typename VP::header_type>>(header), tail, addr);
+  }
+
+  //dual-stack socket reaches IPv4 peers through IPv4-mapped address
+  template<ConnectionSettings CS = default_connection_settings, auto EHP = ehl::Policy::Exception, typename P>
+    requires (SI.type == SocketType::Datagram && SI.dual_stack)
+  [[nodiscard]] ehl::Result_t<void, sys_errc::ErrorCode, EHP> sendto(
+    const P& p, const Address<AddressFamily::IPv4>& addr)
+      noexcept(EHP != ehl::Policy::Exception)
+  {
+    return sendto<CS, EHP>(p, Address<AddressFamily::IPv6>::from_ipv4(addr));
+  }
+
   template<PollFlags PF, auto EHP = ehl::Policy::Exception>
   [[nodiscard]] ehl::Result_t<bool, sys_errc::ErrorCode, EHP> poll(int timeout_ms) noexcept(EHP != ehl::Policy::Exception)
   {
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <type_traits>
+#include "packet.hpp"
+#include "fixed_t.hpp"
+
+namespace cpps
+{
+
+//Packet of fixed header followed by up to MaxCount fixed_t elements, only used elements are transferred.
+//Wire layout: element count (uint32), header, elements; zero padding keeps header and elements aligned.
+//Datagram carries one packet, on streams element count frames packets
+template<packet_type H, fixed_t_type E, std::size_t MaxCount>
+  requires (MaxCount <= std::numeric_limits<std::uint32_t>::max())
+struct var_packet
+{
+  using header_type = H;
+  using element_type = E;
+
+  static constexpr std::size_t max_count = MaxCount;
+
+  static constexpr std::size_t header_offset = (sizeof(std::uint32_t) + alignof(H) - 1) / alignof(H) * alignof(H);
+  static constexpr std::size_t tail_offset = (header_offset + sizeof(H) + alignof(E) - 1) / alignof(E) * alignof(E);
+
+  static constexpr std::size_t size(std::size_t count) noexcept { return tail_offset + count * sizeof(E); }
+
+  static constexpr std::size_t max_size = size(MaxCount);
+
+  //storage of received packet, extra byte detects oversized datagram
+  struct buffer
+  {
+    alignas((std::max)({alignof(std::uint32_t), alignof(H), alignof(E)})) std::byte data[max_size + 1];
+  };
+};
+
+template<typename T>
+struct is_var_packet : std::false_type {};
+
+template<packet_type H, fixed_t_type E, std::size_t MaxCount>
+struct is_var_packet<var_packet<H, E, MaxCount>> : std::true_type {};
+
+template<typename T>
+constexpr bool is_var_packet_v = is_var_packet<T>::value;
+
+template<typename T>
+concept var_packet_type = is_var_packet_v<T>;
+
+//Received var_packet, tail refers to buffer passed to receiving function
+template<var_packet_type VP>
+struct var_packet_view
+{
+  valid_packet<typename VP::header_type> header;
+  std::span<const typename VP::element_type> tail;
+};
+
+} //namespace cpps
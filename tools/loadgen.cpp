@@ -0,0 +1,514 @@
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <string_view>
+#include <thread>
+#include <variant>
+#include <vector>
+#include <cppsocket/cppsocket.hpp>
+#include <cppsocket/details/socket_access.hpp>
+
+//Load generator for TCP/UDP echo servers, reports achieved rate, bandwidth and latency percentiles.
+//
+//  loadgen server --proto tcp --address 127.0.0.1:6969 --packet small
+//  loadgen client --proto tcp --address 127.0.0.1:6969 --packet small
+//                 --connections 64 --threads 4 --rate 200000 --burst 8 --batch 4 --duration 10
+//
+//Load is open loop: packets are sent on fixed schedule whether or not replies came back,
+//and latency is measured from scheduled send time, not from actual one. So stall of server
+//(or of generator itself) shows up as latency of all packets which should have been sent meanwhile
+//instead of silently lowering offered load (coordinated omission).
+
+using clock_type = std::chrono::steady_clock;
+
+struct Small
+{
+  cpps::uint64_t seq;
+  cpps::uint64_t scheduled_ns;
+
+  constexpr bool is_valid() const noexcept { return true; }
+};
+
+struct Large
+{
+  cpps::uint64_t seq;
+  cpps::uint64_t scheduled_ns;
+  cpps::uint64_t payload[30];
+
+  constexpr bool is_valid() const noexcept { return true; }
+};
+
+//alternates between small and large packets
+using Mixed = std::variant<Small, Large>;
+
+struct Options
+{
+  std::string_view mode;
+  std::string_view proto = "tcp";
+  std::string_view packet = "small";
+  cpps::AddressIPv4 address = cpps::AddressIPv4("127.0.0.1", 6969);
+  unsigned connections = 1;
+  unsigned threads = 1;
+  //batches sent back to back on each tick of schedule, spread over connections
+  unsigned burst = 1;
+  //packets sent to one connection with single syscall (gathered write or sendmmsg)
+  unsigned batch = 1;
+  double rate = 10000;
+  double duration = 10;
+};
+
+//Log-linear histogram of nanoseconds, relative error of reported values is below 1/128
+class LatencyHistogram
+{
+  static constexpr unsigned sub_bits = 7;
+  static constexpr std::uint64_t sub_count = std::uint64_t{1} << sub_bits;
+
+  std::vector<std::uint64_t> m_counts_ = std::vector<std::uint64_t>((64 - sub_bits + 1) * sub_count);
+  std::uint64_t m_total_ = 0;
+  std::uint64_t m_max_ = 0;
+
+  static std::size_t index(std::uint64_t v) noexcept
+  {
+    if(v < sub_count) return v;
+
+    const unsigned shift = static_cast<unsigned>(std::bit_width(v)) - sub_bits;
+
+    return shift * sub_count + (v >> shift);
+  }
+
+  //highest value of bucket
+  static std::uint64_t value(std::size_t i) noexcept
+  {
+    const auto shift = i / sub_count;
+    const auto sub = i % sub_count;
+
+    return (sub << shift) + ((std::uint64_t{1} << shift) - 1);
+  }
+
+public:
+  void record(std::uint64_t v) noexcept
+  {
+    ++m_counts_[index(v)];
+    ++m_total_;
+    m_max_ = (std::max)(m_max_, v);
+  }
+
+  void merge(const LatencyHistogram& h) noexcept
+  {
+    for(std::size_t i = 0; i != m_counts_.size(); ++i) m_counts_[i] += h.m_counts_[i];
+
+    m_total_ += h.m_total_;
+    m_max_ = (std::max)(m_max_, h.m_max_);
+  }
+
+  std::uint64_t total() const noexcept { return m_total_; }
+  std::uint64_t max() const noexcept { return m_max_; }
+
+  std::uint64_t percentile(double p) const noexcept
+  {
+    const auto target = static_cast<std::uint64_t>(p / 100 * static_cast<double>(m_total_) + 0.5);
+    std::uint64_t seen = 0;
+
+    for(std::size_t i = 0; i != m_counts_.size(); ++i)
+    {
+      seen += m_counts_[i];
+      if(seen != 0 && seen >= target) return (std::min)(value(i), m_max_);
+    }
+
+    return m_max_;
+  }
+};
+
+struct Stats
+{
+  LatencyHistogram latency;
+  std::uint64_t sent = 0;
+  std::uint64_t received = 0;
+  std::uint64_t bytes_sent = 0;
+  std::uint64_t bytes_received = 0;
+  std::uint64_t errors = 0;
+
+  void merge(const Stats& s) noexcept
+  {
+    latency.merge(s.latency);
+    sent += s.sent;
+    received += s.received;
+    bytes_sent += s.bytes_sent;
+    bytes_received += s.bytes_received;
+    errors += s.errors;
+  }
+};
+
+template<typename P>
+P make_packet(std::uint64_t seq, std::uint64_t scheduled_ns) noexcept
+{
+  if constexpr(std::is_same_v<P, Mixed>)
+  {
+    if(seq % 2 == 0) return Small{{seq}, {scheduled_ns}};
+
+    Large l{};
+    l.seq = {seq};
+    l.scheduled_ns = {scheduled_ns};
+
+    return l;
+  }
+  else
+  {
+    P p{};
+    p.seq = {seq};
+    p.scheduled_ns = {scheduled_ns};
+
+    return p;
+  }
+}
+
+template<typename P>
+std::pair<std::uint64_t, std::size_t> scheduled_and_size(const P& p) noexcept
+{
+  if constexpr(std::is_same_v<P, Mixed>)
+    return std::visit([](const auto& a) { return scheduled_and_size(a); }, p);
+  else
+    return {p.scheduled_ns, sizeof(P)};
+}
+
+std::uint64_t since(clock_type::time_point epoch, clock_type::time_point t) noexcept
+{
+  return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(t - epoch).count());
+}
+
+//Encodes packets as socket would and sends them to its connection with single syscall,
+//gathered write for stream and sendmmsg for datagram sockets
+template<typename Sock, typename P>
+void send_batch(Sock& sock, P* packets, unsigned count, Stats& st) noexcept
+{
+  const auto h = cpps::details::socket_access::handle(sock);
+  const bool convert = sock.converts_byte_order();
+
+  std::size_t sizes[cpps::details::max_batch_size];
+  cpps::uint8_t tags[cpps::details::max_batch_size];
+  cpps::details::const_buffer bufs[2 * cpps::details::max_batch_size];
+  unsigned n = 0;
+
+  for(unsigned i = 0; i != count; ++i)
+  {
+    sizes[i] = scheduled_and_size(packets[i]).second;
+
+    if constexpr(std::is_same_v<P, Mixed>)
+    {
+      //stream variant is framed by index of its alternative
+      if constexpr(Sock::socket_info.type == cpps::SocketType::Stream)
+      {
+        tags[i] = {static_cast<std::uint8_t>(packets[i].index())};
+        if(convert) cpps::details::convert_byte_order(tags[i]);
+
+        bufs[n++] = {&tags[i], sizeof(tags[i])};
+      }
+
+      bufs[n++] = std::visit([convert](auto& p)
+      {
+        if(convert) cpps::details::convert_byte_order(p);
+        return cpps::details::const_buffer{&p, sizeof(p)};
+      }, packets[i]);
+    }
+    else
+    {
+      if(convert) cpps::details::convert_byte_order(packets[i]);
+
+      bufs[n++] = {&packets[i], sizeof(P)};
+    }
+  }
+
+  if constexpr(Sock::socket_info.type == cpps::SocketType::Stream)
+  {
+    //tagged variants may need more buffers than single write takes
+    bool ok = true;
+    for(unsigned i = 0; ok && i < n; i += cpps::details::max_batch_size)
+      ok = cpps::details::send_all(h, bufs + i, (std::min)(n - i, cpps::details::max_batch_size));
+
+    //stream state is unknown after failed write, so whole batch fails
+    if(!ok)
+    {
+      st.errors += count;
+      return;
+    }
+
+    for(unsigned i = 0; i != count; ++i)
+    {
+      ++st.sent;
+      st.bytes_sent += sizes[i];
+    }
+  }
+  else
+  {
+    cpps::details::outgoing_datagram dgrams[cpps::details::max_batch_size];
+    for(unsigned i = 0; i != count; ++i) dgrams[i] = { bufs[i], nullptr, 0 };
+
+    unsigned i = 0;
+    while(i != count)
+    {
+      const int r = cpps::details::send_datagrams(h, dgrams + i, count - i);
+
+      //first datagram failed, count it and continue with others
+      if(r < 0)
+      {
+        ++st.errors;
+        ++i;
+        continue;
+      }
+
+      for(int j = 0; j != r; ++j, ++i)
+      {
+        ++st.sent;
+        st.bytes_sent += sizes[i];
+      }
+    }
+  }
+}
+
+//Worker owning some connections: every interval sends burst of batches, one to each of next connections
+//in round robin, catching up after stalls, and receives replies in between
+template<cpps::SocketInfo SI, typename P>
+void run_client(
+  const Options& o, unsigned connections, double rate, clock_type::time_point epoch, clock_type::time_point stop, Stats& st)
+try
+{
+  auto net = cpps::Net::make();
+
+  std::vector<decltype(net.client_socket<SI>(o.address))> socks;
+  std::vector<pollfd> fds;
+
+  for(unsigned i = 0; i != connections; ++i)
+  {
+    socks.push_back(net.client_socket<SI>(o.address));
+    fds.push_back({ .fd = cpps::details::socket_access::handle(socks.back()), .events = POLLIN, .revents = 0 });
+  }
+
+  const auto interval = std::chrono::nanoseconds(static_cast<std::int64_t>(1e9 * o.burst * o.batch / rate));
+  auto next = epoch;
+  std::uint64_t seq = 0;
+  std::size_t conn = 0;
+
+  //replies are awaited for a while after last send
+  const auto drain_until = stop + std::chrono::seconds(1);
+
+  for(;;)
+  {
+    auto now = clock_type::now();
+
+    while(next <= now && next < stop)
+    {
+      for(unsigned b = 0; b != o.burst; ++b, ++conn)
+      {
+        P batch[cpps::details::max_batch_size];
+        for(unsigned i = 0; i != o.batch; ++i, ++seq) batch[i] = make_packet<P>(seq, since(epoch, next));
+
+        send_batch(socks[conn % socks.size()], batch, o.batch, st);
+      }
+
+      next += interval;
+    }
+
+    if(now >= drain_until || (next >= stop && st.received + st.errors >= st.sent)) break;
+
+    //short waits are spun through, poll has millisecond resolution
+    const auto wait = next < stop ? next - now : drain_until - now;
+    const int timeout = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(wait).count());
+
+    if(::poll(fds.data(), fds.size(), (std::max)(timeout, 0)) <= 0) continue;
+
+    for(std::size_t i = 0; i != fds.size(); ++i)
+    {
+      if(!(fds[i].revents & POLLIN)) continue;
+
+      try
+      {
+        const P p = socks[i].template recv<P>();
+        const auto [scheduled, size] = scheduled_and_size(p);
+
+        ++st.received;
+        st.bytes_received += size;
+        st.latency.record(since(epoch, clock_type::now()) - scheduled);
+      }
+      catch(const sys_errc::ErrorCode&)
+      {
+        ++st.errors;
+        fds[i].fd = -1;
+      }
+    }
+  }
+}
+catch(const sys_errc::ErrorCode& err)
+{
+  std::cerr << "Error: " << err.message() << std::endl;
+}
+
+template<cpps::SocketInfo SI, typename P>
+void client(const Options& o)
+{
+  const unsigned threads = std::clamp(o.threads, 1u, o.connections);
+  std::vector<Stats> stats(threads);
+  std::vector<std::thread> workers;
+
+  //connections are made by workers, schedule starts after they had time to connect
+  const auto epoch = clock_type::now() + std::chrono::milliseconds(100);
+  const auto stop = epoch + std::chrono::duration_cast<clock_type::duration>(std::chrono::duration<double>(o.duration));
+
+  for(unsigned t = 0; t != threads; ++t)
+  {
+    const unsigned conns = o.connections / threads + (t < o.connections % threads);
+    const double rate = o.rate * conns / o.connections;
+
+    workers.emplace_back([&, t, conns, rate] { run_client<SI, P>(o, conns, rate, epoch, stop, stats[t]); });
+  }
+
+  for(auto& w : workers) w.join();
+
+  Stats total;
+  for(const auto& s : stats) total.merge(s);
+
+  const double seconds = o.duration;
+  const auto us = [&](double p) { return static_cast<double>(total.latency.percentile(p)) / 1000; };
+
+  std::printf("sent       %llu (%.0f pps, %.2f MB/s)\n",
+    static_cast<unsigned long long>(total.sent), static_cast<double>(total.sent) / seconds,
+    static_cast<double>(total.bytes_sent) / seconds / 1e6);
+  std::printf("received   %llu (%.0f pps, %.2f MB/s)\n",
+    static_cast<unsigned long long>(total.received), static_cast<double>(total.received) / seconds,
+    static_cast<double>(total.bytes_received) / seconds / 1e6);
+  std::printf("lost       %llu, errors %llu\n",
+    static_cast<unsigned long long>(total.sent - (std::min)(total.sent, total.received + total.errors)),
+    static_cast<unsigned long long>(total.errors));
+  std::printf("latency us p50 %.1f p90 %.1f p99 %.1f p99.9 %.1f p99.99 %.1f max %.1f\n",
+    us(50), us(90), us(99), us(99.9), us(99.99), static_cast<double>(total.latency.max()) / 1000);
+}
+
+template<typename P, typename Sock>
+void echo(Sock conn)
+try
+{
+  for(;;) conn.send(conn.template recv<P>());
+}
+catch(const sys_errc::ErrorCode&) {}
+
+template<cpps::SocketInfo SI, typename P>
+void server(const Options& o)
+{
+  auto net = cpps::Net::make();
+
+  if constexpr(SI.type == cpps::SocketType::Stream)
+  {
+    auto listener = net.server_socket<SI>(o.address, 1024);
+
+    for(;;)
+    {
+      auto [conn, addr] = listener.accept();
+
+      std::thread(echo<P, decltype(conn)>, std::move(conn)).detach();
+    }
+  }
+  else
+  {
+    auto sock = net.server_socket<SI>(o.address);
+
+    for(;;)
+    {
+      try
+      {
+        auto [p, addr] = sock.template recvfrom<P>();
+        sock.sendto(p, addr);
+      }
+      catch(const sys_errc::ErrorCode&) {}
+    }
+  }
+}
+
+template<cpps::SocketInfo SI, typename P>
+void run(const Options& o)
+{
+  if(o.mode == "server")
+    server<SI, P>(o);
+  else
+    client<SI, P>(o);
+}
+
+template<cpps::SocketInfo SI>
+bool run_packet(const Options& o)
+{
+  if(o.packet == "small") run<SI, Small>(o);
+  else if(o.packet == "large") run<SI, Large>(o);
+  else if(o.packet == "mixed") run<SI, Mixed>(o);
+  else return false;
+
+  return true;
+}
+
+template<typename T>
+bool parse_number(std::string_view s, T& v) noexcept
+{
+  const auto [end, ec] = std::from_chars(s.data(), s.data() + s.size(), v);
+  return ec == std::errc{} && end == s.data() + s.size();
+}
+
+bool parse(int argc, char** argv, Options& o)
+{
+  if(argc < 2) return false;
+
+  o.mode = argv[1];
+  if(o.mode != "client" && o.mode != "server") return false;
+
+  for(int i = 2; i + 1 < argc; i += 2)
+  {
+    const std::string_view key = argv[i];
+    const std::string_view value = argv[i + 1];
+
+    bool r = true;
+
+    if(key == "--proto") o.proto = value;
+    else if(key == "--packet") o.packet = value;
+    else if(key == "--address") o.address = cpps::AddressIPv4::parse(value);
+    else if(key == "--connections") r = parse_number(value, o.connections) && o.connections != 0;
+    else if(key == "--threads") r = parse_number(value, o.threads) && o.threads != 0;
+    else if(key == "--burst") r = parse_number(value, o.burst) && o.burst != 0;
+    else if(key == "--batch") r = parse_number(value, o.batch) && o.batch != 0 && o.batch <= cpps::details::max_batch_size;
+    else if(key == "--rate") r = parse_number(value, o.rate) && o.rate > 0;
+    else if(key == "--duration") r = parse_number(value, o.duration) && o.duration > 0;
+    else r = false;
+
+    if(!r) return false;
+  }
+
+  return argc % 2 == 0;
+}
+
+int main(int argc, char** argv) try
+{
+  Options o;
+
+  const bool ok =
+    parse(argc, argv, o) &&
+    (o.proto == "tcp" ? run_packet<cpps::SI_IPv4_TCP>(o) : o.proto == "udp" && run_packet<cpps::SI_IPv4_UDP>(o));
+
+  if(!ok)
+  {
+    std::cerr <<
+      "usage: loadgen client|server [--proto tcp|udp] [--address ip:port] [--packet small|large|mixed]\n"
+      "                             [--connections n] [--threads n] [--rate pps] [--burst n] [--batch n]\n"
+      "                             [--duration s]\n";
+
+    return 1;
+  }
+}
+catch(const cpps::AddressError&)
+{
+  std::cerr << "Error: invalid address" << std::endl;
+  return 1;
+}
+catch(const sys_errc::ErrorCode& err)
+{
+  std::cerr << "Error: " << err.message() << std::endl;
+  return 1;
+}